@@ -5,12 +5,11 @@
 #include "client.hpp"
 
 #include "common/action_if_exists.hpp"
+#include "common/logger.hpp"
 #include "common/pc_adapters.hpp"
 #include "common/task.hpp"
 #include "protocol/protocol.hpp"
 
-#include <iostream>
-
 namespace tsvetkov {
 
 namespace {
@@ -21,34 +20,145 @@ std::shared_ptr<typename tsvetkov::traits::function_traits<F>::return_type> make
     return std::make_shared<typename tsvetkov::traits::function_traits<F>::return_type>(
         make_buffer(std::forward<Args>(args)...));
 }
+
+// Non-owning buffer sequence over Client::write_buffers, cheap for asio to copy.
+struct ConstBufferView
+{
+    const asio::const_buffer* begin() const
+    {
+        return first;
+    }
+    const asio::const_buffer* end() const
+    {
+        return last;
+    }
+
+    const asio::const_buffer* first;
+    const asio::const_buffer* last;
+};
 } // namespace
 
-Client::Client(asio::io_context& io, const std::string& remote_address, std::uint16_t port)
-    : io_context(io), client_strand(io), socket(io), endpoint(asio::ip::make_address(remote_address), port)
+Client::Client(asio::io_context& io,
+               const std::string& remote_address,
+               std::uint16_t port,
+               ClientOptions client_options)
+    : Client(SerialExecutor::strand(io), remote_address, port, client_options)
 {
+}
+
+Client::Client(SerialExecutor executor,
+               const std::string& remote_address,
+               std::uint16_t port,
+               ClientOptions client_options)
+    : options(client_options),
+      io_context(executor.context()),
+      client_executor(std::move(executor)),
+      timing_wheel(asio::use_service<TimingWheel>(io_context)),
+      socket(io_context),
+      endpoint(asio::ip::make_address(remote_address), port),
+      command_pool(options.max_pending_requests),
+      output_buffer(options.max_queued_frames, options.interactive_weight),
+      rtt(options.initial_rto, options.min_rto, options.max_rto, TimingWheel::resolution),
+      reconnect_backoff(options.reconnect_initial_delay, options.reconnect_max_delay, std::random_device{}()),
+      request(options.max_pending_requests),
+      request_slots(std::make_unique<RequestSlot[]>(request.capacity()))
+{
+    writing_frames.reserve(options.max_write_frames);
+    write_buffers.reserve(options.max_write_frames);
+    rto = rtt.rto().count();
+
+    // The wheel calls these with its lock held: only hop onto the client's executor.
+    ping_timer.set_callback([this] {
+        client_executor.post(action_if_exists(weak_from_this(), [](Client* self) { self->on_ping_timer(); }));
+    });
+    reconnect_timer.set_callback([this] {
+        client_executor.post(action_if_exists(weak_from_this(), [](Client* self) { self->impl_async_connect(); }));
+    });
+    handshake_timer.set_callback([this] {
+        client_executor.post(action_if_exists(weak_from_this(), [](Client* self) { self->on_handshake_timeout(); }));
+    });
+    for (std::size_t slot = 0; slot < request.capacity(); ++slot) {
+        request_slots[slot].timer.set_callback([this, slot] {
+            auto id = request_slots[slot].armed_id.load(std::memory_order_relaxed);
+            client_executor.post(
+                action_if_exists(weak_from_this(), [slot, id](Client* self) { self->on_request_deadline(slot, id); }));
+        });
+    }
+
     commandHandler.subscribe([this](std::uint32_t id, protocol::HelloResponse hello_response) {
-        std::cout << "HelloResponse" << std::endl;
-        std::cout << "hello_response.type_device: " << static_cast<std::uint32_t>(hello_response.type_device)
-                  << std::endl;
-        std::cout << "hello_response.low_device_id: " << hello_response.low_device_id << std::endl;
-        std::cout << "hello_response.high_device_id: " << hello_response.high_device_id << std::endl;
+        log_debug("client",
+                  "HelloResponse, type_device: ",
+                  static_cast<std::uint32_t>(hello_response.type_device),
+                  ", high_device_id: ",
+                  hello_response.high_device_id,
+                  ", low_device_id: ",
+                  hello_response.low_device_id);
+
+        auto reported = make_device_id(hello_response.high_device_id, hello_response.low_device_id);
+        if (this->options.verify_device_id && this->expected_device && *this->expected_device != reported) {
+            // The address belongs to another strip now: talking to it would act on the wrong device.
+            log_warning("client",
+                        remote_address(),
+                        " is device ",
+                        hello_response.high_device_id,
+                        ':',
+                        hello_response.low_device_id,
+                        ", expected ",
+                        *this->expected_device >> 32,
+                        ':',
+                        *this->expected_device & 0xffffffffu);
+            this->wrong_devices.fetch_add(1, std::memory_order_relaxed);
+            this->impl_disconnect();
+            this->timing_wheel.schedule(this->reconnect_timer, this->reconnect_backoff.next());
+            return;
+        }
+        this->device_id = reported;
 
         // Connection task, step 1
         if (this->hello_response_promise) {
-            this->hello_response_promise->set_value(hello_response);
+            auto promise = std::move(*this->hello_response_promise);
+            this->hello_response_promise.reset();
+            promise.set_value(hello_response);
         }
     });
     commandHandler.subscribe([this](protocol::SmartPowerStatus smart_power_status) {
-        std::cout << "Status notification" << std::endl;
-        for (const auto& item : smart_power_status.status) {
-            std::cout << "smart_power_status, pin: " << static_cast<int>(item.first)
-                      << " status: " << (item.second == protocol::SmartPowerStatus::Status::On ? "On" : "Off")
-                      << std::endl;
+        auto previous   = this->pin_state;
+        this->pin_state = PinState::from_status(smart_power_status);
+        if (this->options.status_stream) {
+            this->options.status_stream->publish(this->device_id, previous, this->pin_state);
+        }
+        DeviceSnapshot snapshot;
+        snapshot.device        = this->device_id;
+        snapshot.pin_state     = this->pin_state;
+        snapshot.notifications = ++this->notifications;
+        snapshot.updated_at    = std::chrono::steady_clock::now();
+        snapshot.is_present    = true;
+        this->latest.store(snapshot);
+
+        log_debug("client",
+                  "Status notification, pins: ",
+                  this->pin_state.size(),
+                  ", on: ",
+                  this->pin_state.on.count());
+        if (log_enabled<LogLevel::Trace>()) {
+            this->pin_state.present.for_each([this](std::uint8_t pin) {
+                log_trace("client",
+                          "smart_power_status, pin: ",
+                          pin,
+                          " status: ",
+                          this->pin_state.on.test(pin) ? "On" : "Off");
+            });
+        }
+
+        if (this->status_handler) {
+            this->status_handler(this->pin_state);
         }
 
         // Connection task, step 2
-        if (this->smart_power_status_promise) {
-            this->smart_power_status_promise->set_value(std::move(smart_power_status));
+        if (this->pin_state_promise) {
+            auto promise = std::move(*this->pin_state_promise);
+            this->pin_state_promise.reset();
+            promise.set_value(this->pin_state);
         }
     });
     commandHandler.subscribe([this](std::uint32_t id, protocol::OkResponse) {
@@ -57,17 +167,26 @@ Client::Client(asio::io_context& io, const std::string& remote_address, std::uin
         response(id, std::nullopt);
     });
     commandHandler.subscribe([this](std::uint32_t id, protocol::ErrorResponse error_response) {
-        std::cout << "ErrorResponse" << std::endl;
-        std::cout << "id: " << id << std::endl;
+        log_warning("client", "ErrorResponse, id: ", id);
         response(id, error_response.error_response_type);
     });
 }
 
-pc::future<protocol::SmartPowerStatus> Client::async_connect()
+Client::~Client()
 {
-    return pc::async(client_strand, action_if_exists(make_single_context(shared_from_this()), [](Client* self) {
+    while (auto command = submitted_commands.pop()) {
+        command_pool.release(command);
+    }
+}
+
+pc::future<PinState> Client::async_connect()
+{
+    return pc::async(client_executor, action_if_exists(make_single_context(shared_from_this()), [](Client* self) {
+                         if (self->state == ConnectionState::Connected) {
+                             return pc::make_ready_future(self->pin_state);
+                         }
                          self->connections_to_client.emplace_back();
-                         if (self->connections_to_client.size() == 1) {
+                         if (self->connections_to_client.size() == 1 && self->state != ConnectionState::Connecting) {
                              self->impl_async_connect();
                          }
                          return self->connections_to_client.back().get_future();
@@ -76,14 +195,53 @@ pc::future<protocol::SmartPowerStatus> Client::async_connect()
 
 void Client::impl_async_connect()
 {
-    ping_task = {};
+    state = ConnectionState::Connecting;
+    timing_wheel.cancel(ping_timer);
+    timing_wheel.cancel(reconnect_timer);
+    if (!options.handshake_limiter || handshake_permit) {
+        impl_handshake();
+        return;
+    }
+    options.handshake_limiter->acquire([weak_self = weak_from_this()](AdmissionLimiter::Permit permit) {
+        auto self = weak_self.lock();
+        if (!self) {
+            return;
+        }
+        self->client_executor.post([weak_self, permit = std::move(permit)]() mutable {
+            auto self = weak_self.lock();
+            if (!self || self->state != ConnectionState::Connecting) {
+                return;
+            }
+            self->handshake_permit = std::move(permit);
+            self->impl_handshake();
+        });
+    });
+}
+
+void Client::impl_handshake()
+{
+    timing_wheel.schedule(handshake_timer, options.handshake_timeout);
+    // Commands queued since the last connection was lost are discarded with their frames, so fail them now rather
+    // than at their deadline, or never if they have none.
+    fail_pending_requests(std::errc::connection_aborted);
     output_buffer.clear();
+    writing_frames.clear();
+    is_async_write = false;
+    incoming_buffer.clear();
     auto single_ctx = make_single_context(shared_from_this());
     asio::async_connect(socket, std::vector<asio::ip::tcp::endpoint>{endpoint}, use_future)
-        .next(client_strand,
+        .next(client_executor,
               action_if_exists(single_ctx,
                                [](Client* self, const asio::ip::tcp::endpoint&) {
-                                   std::cout << "async_connect ok!" << std::endl;
+                                   log_debug("client", "async_connect ok");
+                                   if (self->options.send_buffer_size > 0) {
+                                       std::error_code ec;
+                                       self->socket.set_option(
+                                           asio::socket_base::send_buffer_size(self->options.send_buffer_size), ec);
+                                       if (ec) {
+                                           log_warning("client", "send buffer size: ", ec);
+                                       }
+                                   }
                                    self->async_read();
                                    self->hello_response_promise = pc::promise<protocol::HelloResponse>();
                                    self->send_hello_request();
@@ -91,70 +249,216 @@ void Client::impl_async_connect()
                                }))
         .next(action_if_exists(single_ctx,
                                [](Client* self, protocol::HelloResponse) {
-                                   self->hello_response_promise.reset();
-                                   self->smart_power_status_promise = pc::promise<protocol::SmartPowerStatus>();
-                                   return self->smart_power_status_promise->get_future();
+                                   self->pin_state_promise = pc::promise<PinState>();
+                                   return self->pin_state_promise->get_future();
                                }))
         .next(action_if_exists(single_ctx,
-                               [](Client* self, protocol::SmartPowerStatus smart_power_status) {
+                               [](Client* self, PinState pin_state) {
                                    self->set_async_connect_result(
-                                       [&](pc::promise<protocol::SmartPowerStatus>& promise) {
-                                           promise.set_value(smart_power_status);
-                                       });
-                                   self->last_response_ping = std::chrono::steady_clock::now();
-                                   self->start_ping();
+                                       [&](pc::promise<PinState>& promise) { promise.set_value(pin_state); });
+                                   self->state                  = ConnectionState::Connected;
+                                   self->inbound_frames_at_tick = self->inbound_frames;
+                                   self->timing_wheel.cancel(self->handshake_timer);
+                                   self->handshake_permit.release();
+                                   self->reconnect_backoff.reset();
+                                   self->ping_id.reset();
+                                   self->is_probing       = false;
+                                   self->is_ping_answered = false;
+                                   self->unanswered_pings = 0;
+                                   self->start_ping(self->options.keepalive_idle);
                                }))
         .then([single_ctx](pc::future<void> future) {
             try {
                 future.get();
             } catch (const context_is_destroyed&) {
-                std::cout << "Connection error: context is destroyed" << std::endl;
+                log_warning("client", "Connection error: context is destroyed");
             } catch (const std::system_error& e) {
-                std::cout << "Connection system_error: " << e.what() << std::endl;
-                action_if_exists(single_ctx, &Client::system_error_filter)(e, [single_ctx](Client* self) {
-                    auto reconnect_timer = std::make_shared<asio::steady_timer>(self->io_context);
-                    reconnect_timer->expires_after(std::chrono::seconds(5));
-                    reconnect_timer->async_wait(use_future)
-                        .next(self->client_strand,
-                              action_if_exists(single_ctx,
-                                               [reconnect_timer](Client* self) { self->impl_async_connect(); }))
-                        .detach();
+                log_warning("client", "Connection system_error: ", e.what());
+                action_if_exists(single_ctx, &Client::system_error_filter)(e, [](Client* self) {
+                    self->state = ConnectionState::Disconnected;
+                    self->timing_wheel.cancel(self->handshake_timer);
+                    self->handshake_permit.release();
+                    self->fail_pending_requests(std::errc::connection_aborted);
+                    self->timing_wheel.schedule(self->reconnect_timer, self->reconnect_backoff.next());
                 });
             } catch (const std::exception& e) {
-                std::cout << "Connection error: exception " << e.what() << std::endl;
+                log_error("client", "Connection error: exception ", e.what());
             }
         })
         .detach();
 }
 
-protocol::SmartPowerStatus Client::connect()
+PinState Client::connect()
 {
     return async_connect().get();
 }
 
+pc::future<void> Client::async_disconnect()
+{
+    return async_post([self = shared_from_this()] {
+        self->timing_wheel.cancel(self->reconnect_timer);
+        self->state = ConnectionState::Disconnected;
+        self->impl_disconnect();
+        self->set_async_connect_result([](pc::promise<PinState>& promise) {
+            promise.set_exception(
+                std::make_exception_ptr(std::system_error(std::make_error_code(std::errc::connection_aborted))));
+        });
+    });
+}
+
 void Client::disconnect()
 {
-    async_post([this] {
-        std::error_code ec;
-        socket.close(ec);
-        if (ec) {
-            std::cout << "Client::disconnect()" << ec << ": " << ec.message() << std::endl;
+    async_disconnect().get();
+}
+
+pc::future<Client::command_result_type> Client::async_send_all_on()
+{
+    return async_send_all_on(options.request_timeout);
+}
+
+pc::future<Client::command_result_type> Client::async_send_all_on(timeout_type timeout, Lane lane)
+{
+    return submit(Command::Type::AllOn, 0, timeout, lane);
+}
+
+pc::future<Client::command_result_type> Client::async_send_all_off()
+{
+    return async_send_all_off(options.request_timeout);
+}
+
+pc::future<Client::command_result_type> Client::async_send_all_off(timeout_type timeout, Lane lane)
+{
+    return submit(Command::Type::AllOff, 0, timeout, lane);
+}
+
+pc::future<Client::command_result_type> Client::async_inversion(std::uint8_t pin)
+{
+    return async_inversion(pin, options.request_timeout);
+}
+
+pc::future<Client::command_result_type> Client::async_inversion(std::uint8_t pin, timeout_type timeout, Lane lane)
+{
+    return submit(Command::Type::Inversion, pin, timeout, lane);
+}
+
+pc::future<Client::command_result_type> Client::submit(Command::Type type,
+                                                      std::uint8_t pin,
+                                                      timeout_type timeout,
+                                                      Lane lane)
+{
+    auto command     = command_pool.acquire();
+    command->type    = type;
+    command->pin     = pin;
+    command->timeout = timeout;
+    command->lane    = lane;
+    auto result      = command->promise.get_future();
+    submitted_commands.push(command.release());
+    if (!is_drain_scheduled.exchange(true, std::memory_order_acq_rel)) {
+        client_executor.post(action_if_exists(weak_from_this(), [](Client* self) { self->drain_commands(); }));
+    }
+    return result;
+}
+
+void Client::drain_commands()
+{
+    // Cleared before popping: a producer that pushes after this point schedules the next drain itself.
+    is_drain_scheduled.exchange(false, std::memory_order_acq_rel);
+    std::uint64_t drained = 0;
+    while (auto popped = submitted_commands.pop()) {
+        CommandPool::handle_type command(popped, CommandPool::Release{&command_pool});
+        ++drained;
+        auto id = next_request_id();
+        if (!id) {
+            command->promise.set_exception(std::make_exception_ptr(
+                std::system_error(std::make_error_code(std::errc::resource_unavailable_try_again))));
+            continue;
+        }
+        auto pushed = output_buffer.push_command(
+            command->lane, encode(*command, *id), frame_effect(*command), command->pin, *id,
+            [this](std::uint32_t elided, std::optional<std::uint32_t> superseded_by) {
+                elide_request(elided, superseded_by);
+            });
+        if (pushed == PushResult::Cancelled) {
+            commands_coalesced.fetch_add(1, std::memory_order_relaxed);
+            command->promise.set_value(std::nullopt);
+            continue;
         }
-    }).get();
+        if (pushed == PushResult::Rejected) {
+            commands_rejected.fetch_add(1, std::memory_order_relaxed);
+            finish_request(request.slot(*id), std::move(command->promise), [](auto& promise) {
+                promise.set_exception(
+                    std::make_exception_ptr(std::system_error(std::make_error_code(std::errc::no_buffer_space))));
+            });
+            continue;
+        }
+        request.insert(*id, std::move(command->promise));
+        start_request_deadline(*id, command->timeout);
+    }
+    // A wakeup can find the queue empty: its command was taken by the drain already running when it was posted.
+    command_drains.fetch_add(1, std::memory_order_relaxed);
+    if (drained != 0) {
+        commands_drained.fetch_add(drained, std::memory_order_relaxed);
+        update_congestion();
+        async_write();
+    }
+}
+
+Frame Client::encode(const Command& command, std::uint32_t id)
+{
+    switch (command.type) {
+    case Command::Type::AllOn:
+        return Frame(protocol::make_all_on_command(id));
+    case Command::Type::AllOff:
+        return Frame(protocol::make_all_off_command(id));
+    case Command::Type::Inversion:
+        return Frame(protocol::make_inversion_command(id, command.pin));
+    }
+    throw std::invalid_argument("unknown command type");
+}
+
+FrameEffect Client::frame_effect(const Command& command) const
+{
+    if (!options.coalesce_commands) {
+        return FrameEffect::None;
+    }
+    return command.type == Command::Type::Inversion ? FrameEffect::Toggle : FrameEffect::SetAll;
+}
+
+// Called by the output queue while the new command is being queued, so `superseded_by` is not in `request` yet.
+void Client::elide_request(std::uint32_t id, std::optional<std::uint32_t> superseded_by)
+{
+    auto request_promise = request.take(id);
+    if (!request_promise) {
+        // already timed out
+        return;
+    }
+    commands_coalesced.fetch_add(1, std::memory_order_relaxed);
+    auto slot = request.slot(id);
+    timing_wheel.cancel(request_slots[slot].timer);
+    if (!superseded_by) {
+        finish_request(slot, std::move(*request_promise), [](auto& promise) { promise.set_value(std::nullopt); });
+        return;
+    }
+    auto& superseded = request_slots[request.slot(*superseded_by)].superseded;
+    superseded.push_back(std::move(*request_promise));
+    for (auto& promise : request_slots[slot].superseded) {
+        superseded.push_back(std::move(promise));
+    }
+    request_slots[slot].superseded.clear();
 }
 
 void Client::send_all_on()
 {
-    async_add_request(&tsvetkov::protocol::make_all_on_command).get();
+    async_send_all_on().get();
 }
 void Client::send_all_off()
 {
-    async_add_request(&tsvetkov::protocol::make_all_off_command).get();
+    async_send_all_off().get();
 }
 
 void Client::inversion(std::uint8_t pin)
 {
-    async_add_request(&tsvetkov::protocol::make_inversion_command, pin).get();
+    async_inversion(pin).get();
 }
 
 void Client::send_hello_request()
@@ -162,15 +466,29 @@ void Client::send_hello_request()
     push_to_queue(tsvetkov::protocol::make_hello_request(next_id()));
 }
 
-void Client::send_ping()
+// Enqueued directly (we are on the client executor) so that the id and the send time are known for the RTT sample.
+bool Client::send_ping()
 {
-    async_add_request(tsvetkov::protocol::make_ping_command)
-        .next(client_strand,
-              action_if_exists(make_single_context(shared_from_this()),
-                               [](Client* self, std::optional<protocol::ErrorResponseType>) {
-                                   self->last_response_ping = std::chrono::steady_clock::now();
-                               }))
-        .detach();
+    auto id = next_request_id();
+    if (!id) {
+        return false;
+    }
+    request.insert(*id, pc::promise<std::optional<protocol::ErrorResponseType>>());
+    start_request_deadline(*id, options.request_timeout);
+    ping_id      = *id;
+    ping_sent_at = std::chrono::steady_clock::now();
+    push_to_queue(tsvetkov::protocol::make_ping_command(*id));
+    return true;
+}
+
+void Client::update_congestion()
+{
+    auto queued = output_buffer.size(Lane::Interactive) + output_buffer.size(Lane::Bulk);
+    if (queued >= options.max_queued_frames / 4 * 3) {
+        is_congested_flag.store(true, std::memory_order_relaxed);
+    } else if (queued <= options.max_queued_frames / 4) {
+        is_congested_flag.store(false, std::memory_order_relaxed);
+    }
 }
 
 void Client::async_write()
@@ -179,18 +497,46 @@ void Client::async_write()
         return;
     }
     is_async_write = true;
-    auto buffer    = std::make_unique<std::string>(std::move(output_buffer.front()));
-    output_buffer.pop_front();
-    auto buffer_ptr = buffer.get();
+
+    std::size_t bytes = 0;
+    while (!output_buffer.empty() && writing_frames.size() < std::max<std::size_t>(options.max_write_frames, 1)) {
+        auto& frame = output_buffer.front();
+        if (!writing_frames.empty() && bytes + frame.size() > options.max_write_bytes) {
+            break;
+        }
+        bytes += frame.size();
+        writing_frames.push_back(std::move(frame));
+        output_buffer.pop_front();
+    }
+
+    update_congestion();
+
+    write_buffers.clear();
+    for (const auto& frame : writing_frames) {
+        write_buffers.emplace_back(asio::buffer(frame.data(), frame.size()));
+    }
+    write_position = 0;
+    async_write_some();
+}
+
+void Client::async_write_some()
+{
     auto single_ctx = make_single_context(shared_from_this());
-    asio::async_write(socket, asio::buffer(*buffer_ptr), use_future)
-        .next(client_strand,
+    auto unwritten =
+        ConstBufferView{write_buffers.data() + write_position, write_buffers.data() + write_buffers.size()};
+    socket.async_write_some(unwritten, use_future)
+        .next(client_executor,
               action_if_exists(single_ctx,
-                               [buffer = std::move(buffer)](Client* self, std::size_t bytes_transferred) {
-                                   //                                   std::cout << "async_write, bytes_transferred: "
-                                   //                                   << bytes_transferred
-                                   //                                             << " buffer: " << buffer->size() <<
-                                   //                                             std::endl;
+                               [](Client* self, std::size_t bytes_transferred) {
+                                   self->write_syscalls.fetch_add(1, std::memory_order_relaxed);
+                                   if (!self->consume_written(bytes_transferred)) {
+                                       self->partial_writes.fetch_add(1, std::memory_order_relaxed);
+                                       self->async_write_some();
+                                       return;
+                                   }
+                                   self->frames_written.fetch_add(self->writing_frames.size(),
+                                                                  std::memory_order_relaxed);
+                                   self->writing_frames.clear();
                                    self->is_async_write = false;
                                    self->async_write();
                                }))
@@ -198,55 +544,79 @@ void Client::async_write()
             try {
                 future.get();
             } catch (const std::system_error& e) {
-                std::cout << "async_write system_error: " << e.what() << std::endl;
+                log_warning("client", "async_write system_error: ", e.what());
                 action_if_exists(single_ctx, &Client::system_error_filter)(e, [](Client* self) {
                     self->impl_disconnect();
                     self->reconnect();
                 });
             } catch (const std::exception& e) {
-                std::cout << "async_write error: " << e.what() << std::endl;
+                log_error("client", "async_write error: ", e.what());
             }
         })
         .detach();
 }
 
+// Advances the in-flight write past `bytes_transferred`, returns true once everything is written.
+bool Client::consume_written(std::size_t bytes_transferred)
+{
+    while (write_position < write_buffers.size() && bytes_transferred >= write_buffers[write_position].size()) {
+        bytes_transferred -= write_buffers[write_position].size();
+        ++write_position;
+    }
+    if (write_position < write_buffers.size()) {
+        write_buffers[write_position] += bytes_transferred;
+    }
+    return write_position == write_buffers.size();
+}
+
 void Client::async_read()
 {
-    auto single_ctx          = make_single_context(shared_from_this());
-    auto incoming_buffer     = std::make_unique<std::array<char, 1024>>();
-    auto incoming_buffer_ptr = incoming_buffer.get();
-    socket.async_read_some(asio::buffer(*incoming_buffer_ptr), use_future)
-        .next(client_strand,
+    auto single_ctx = make_single_context(shared_from_this());
+    socket.async_read_some(incoming_buffer.prepare(), use_future)
+        .next(client_executor,
               action_if_exists(
                   single_ctx,
-                  [incoming_buffer = std::move(incoming_buffer)](Client* client, std::size_t bytes_transferred) {
+                  [](Client* client, std::size_t bytes_transferred) {
                       //                      std::cout << "async_read, bytes_transferred: " << bytes_transferred <<
                       //                      std::endl;
 
-                      client->accumulate_incoming_buffer.append(&(*incoming_buffer)[0], bytes_transferred);
+                      // Read completed just before disconnect() closed the socket: drop it, so nothing is
+                      // reported for a disconnected client.
+                      if (client->state == ConnectionState::Disconnected) {
+                          return;
+                      }
+                      auto& buffer = client->incoming_buffer;
+                      buffer.commit(bytes_transferred);
 
-                      while (true) {
-                          // size packet
-                          if (client->accumulate_incoming_buffer.size() < protocol::Message::packet_size) {
-                              break;
-                          }
+                      while (buffer.size() >= protocol::Message::packet_size) {
+                          auto size_packet =
+                              protocol::expected_packet_size(buffer.peek(protocol::Message::packet_size));
 
-                          auto data        = &client->accumulate_incoming_buffer[0];
-                          auto size_packet = protocol::expected_packet_size(data);
+                          if (size_packet < protocol::Message::packet_size ||
+                              size_packet > incoming_buffer_type::capacity) {
+                              log_error("client", "async_read, invalid packet size: ", size_packet);
+                              client->impl_disconnect();
+                              client->reconnect();
+                              return;
+                          }
 
-                          if (size_packet > client->accumulate_incoming_buffer.size()) {
+                          if (size_packet > buffer.size()) {
                               break;
                           }
 
-                          auto ec = client->commandHandler.parse(data, client->accumulate_incoming_buffer.size());
-                          if (!client->accumulate_incoming_buffer.empty()) {
-                              client->accumulate_incoming_buffer.erase(0, size_packet);
-                          }
+                          auto ec = client->commandHandler.parse(buffer.peek(size_packet), size_packet);
+                          buffer.consume(size_packet);
                           if (ec) {
-                              std::cout << "async_read, parse failed: " << ec << ": " << ec.message() << std::endl;
-                              client->disconnect();
+                              log_error("client", "async_read, parse failed: ", ec);
+                              client->impl_disconnect();
+                              client->reconnect();
+                              return;
+                          }
+                          // a handler refused the device
+                          if (client->state == ConnectionState::Disconnected) {
                               return;
                           }
+                          ++client->inbound_frames;
                       }
                       client->async_read();
                   }))
@@ -254,46 +624,151 @@ void Client::async_read()
             try {
                 future.get();
             } catch (const std::system_error& e) {
-                std::cout << "async read system_error: " << e.what() << std::endl;
+                log_warning("client", "async read system_error: ", e.what());
                 action_if_exists(single_ctx, &Client::system_error_filter)(e, [](Client* self) {
                     self->impl_disconnect();
                     self->reconnect();
                 });
             } catch (const std::exception& e) {
-                std::cout << "async read error: " << e.what() << std::endl;
+                log_error("client", "async read error: ", e.what());
             }
         })
         .detach();
 }
 
-void Client::start_ping()
-{
-    auto timer = std::make_shared<asio::steady_timer>(io_context);
-    timer->expires_after(std::chrono::seconds(1));
-    ping_task = timer->async_wait(use_future)
-                    .then(client_strand,
-                          action_if_exists(make_single_context(shared_from_this()),
-                                           [timer](Client* self, pc::promise<void> complete, pc::future<void> future) {
-                                               if (!complete.is_awaiten()) {
-                                                   return;
-                                               }
-                                               auto now = std::chrono::steady_clock::now();
-                                               if (now - self->last_response_ping > std::chrono::seconds(5)) {
-                                                   self->impl_disconnect();
-                                                   self->reconnect();
-                                               } else {
-                                                   self->send_ping();
-                                                   self->start_ping();
-                                               }
-                                           }));
+void Client::start_ping(std::chrono::steady_clock::duration delay)
+{
+    timing_wheel.schedule(ping_timer, delay);
+}
+
+void Client::on_ping_timer()
+{
+    if (state != ConnectionState::Connected) {
+        return;
+    }
+    // The reply to our own ping is not traffic.
+    auto received          = inbound_frames - inbound_frames_at_tick;
+    auto is_traffic        = received > (is_ping_answered ? 1u : 0u);
+    inbound_frames_at_tick = inbound_frames;
+
+    if (is_traffic) {
+        ping_id.reset();
+        is_probing       = false;
+        is_ping_answered = false;
+        unanswered_pings = 0;
+        pings_suppressed.fetch_add(1, std::memory_order_relaxed);
+        start_ping(options.keepalive_idle);
+        return;
+    }
+    if (is_ping_answered) {
+        // answered within its RTO, sit out the rest of the idle period
+        is_probing       = false;
+        is_ping_answered = false;
+        unanswered_pings = 0;
+        start_ping(options.keepalive_idle - (std::chrono::steady_clock::now() - ping_sent_at));
+        return;
+    }
+    if (is_probing && ++unanswered_pings >= options.keepalive_probes) {
+        log_warning("client",
+                    unanswered_pings,
+                    " pings without reply, rto: ",
+                    std::chrono::duration_cast<std::chrono::milliseconds>(rtt.rto()).count(),
+                    " ms");
+        impl_disconnect();
+        reconnect();
+        return;
+    }
+    // A ping that could not get a request id counts as unanswered too, or a full request table would keep the link
+    // up forever.
+    is_probing = true;
+    if (send_ping()) {
+        pings_sent.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        log_debug("client", "ping not sent: no free request id");
+    }
+    start_ping(rtt.backoff(unanswered_pings));
 }
 
+void Client::on_ping_response()
+{
+    rtt.add_sample(std::chrono::steady_clock::now() - ping_sent_at);
+    ping_id.reset();
+    is_ping_answered = true;
+
+    rtt_samples.store(rtt.samples(), std::memory_order_relaxed);
+    srtt.store(rtt.srtt().count(), std::memory_order_relaxed);
+    rttvar.store(rtt.rttvar().count(), std::memory_order_relaxed);
+    rto.store(rtt.rto().count(), std::memory_order_relaxed);
+}
+
+void Client::on_handshake_timeout()
+{
+    if (state != ConnectionState::Connecting) {
+        return;
+    }
+    log_warning("client", "handshake timed out");
+    impl_disconnect();
+    timing_wheel.schedule(reconnect_timer, reconnect_backoff.next());
+}
+
+// After a link drop every client of the site tends to get here at the same moment: retry after a jittered delay.
 void Client::reconnect()
 {
-    if (!connections_to_client.empty()) {
+    if (state == ConnectionState::Connecting || timing_wheel.is_scheduled(reconnect_timer)) {
         return;
     }
-    async_connect().detach();
+    timing_wheel.schedule(reconnect_timer, reconnect_backoff.next());
+}
+
+ConnectionState Client::connection_state() const
+{
+    return state;
+}
+
+std::string Client::remote_address() const
+{
+    return endpoint.address().to_string();
+}
+
+void Client::set_status_handler(status_handler_type handler)
+{
+    status_handler = std::move(handler);
+}
+
+void Client::set_expected_device(DeviceId id)
+{
+    expected_device = id;
+}
+
+DeviceSnapshot Client::snapshot() const
+{
+    return latest.load();
+}
+
+bool Client::is_congested() const
+{
+    return is_congested_flag.load(std::memory_order_relaxed);
+}
+
+ClientStats Client::stats() const
+{
+    ClientStats result;
+    result.frames_written     = frames_written.load(std::memory_order_relaxed);
+    result.write_syscalls     = write_syscalls.load(std::memory_order_relaxed);
+    result.partial_writes     = partial_writes.load(std::memory_order_relaxed);
+    result.commands_drained   = commands_drained.load(std::memory_order_relaxed);
+    result.command_drains     = command_drains.load(std::memory_order_relaxed);
+    result.commands_rejected  = commands_rejected.load(std::memory_order_relaxed);
+    result.commands_coalesced = commands_coalesced.load(std::memory_order_relaxed);
+    result.pings_sent         = pings_sent.load(std::memory_order_relaxed);
+    result.pings_suppressed   = pings_suppressed.load(std::memory_order_relaxed);
+    result.rtt_samples        = rtt_samples.load(std::memory_order_relaxed);
+    result.srtt               = std::chrono::steady_clock::duration(srtt.load(std::memory_order_relaxed));
+    result.rttvar             = std::chrono::steady_clock::duration(rttvar.load(std::memory_order_relaxed));
+    result.rto                = std::chrono::steady_clock::duration(rto.load(std::memory_order_relaxed));
+    result.link_drops         = link_drops.load(std::memory_order_relaxed);
+    result.wrong_devices      = wrong_devices.load(std::memory_order_relaxed);
+    return result;
 }
 
 std::uint32_t Client::next_id()
@@ -301,22 +776,98 @@ std::uint32_t Client::next_id()
     return counter_id++;
 }
 
+// Skips ids whose slot is still held by an older request; fails only when the table is full.
+std::optional<std::uint32_t> Client::next_request_id()
+{
+    for (std::size_t i = 0; i < request.capacity(); ++i) {
+        auto id = next_id();
+        if (request.is_free(id)) {
+            return id;
+        }
+    }
+    return std::nullopt;
+}
+
 void Client::response(std::uint32_t id, std::optional<protocol::ErrorResponseType> error_response)
 {
-    auto it = request.find(id);
-    if (it == request.end()) {
+    auto request_promise = request.take(id);
+    if (!request_promise) {
         return;
     }
-    it->second.set_value(error_response);
-    request.erase(it);
+    timing_wheel.cancel(request_slots[request.slot(id)].timer);
+    if (ping_id == id) {
+        on_ping_response();
+    }
+    finish_request(request.slot(id), std::move(*request_promise),
+                   [&](auto& promise) { promise.set_value(error_response); });
+}
+
+void Client::start_request_deadline(std::uint32_t id, timeout_type timeout)
+{
+    auto& deadline = request_slots[request.slot(id)];
+    deadline.id    = id;
+    if (timeout > timeout_type::zero()) {
+        // Stored before scheduling, whose lock orders it before the wheel reads it.
+        deadline.armed_id.store(id, std::memory_order_relaxed);
+        timing_wheel.schedule(deadline.timer, timeout);
+    }
+}
+
+void Client::on_request_deadline(std::size_t slot, std::uint32_t id)
+{
+    // Posted before the request was answered and the slot reused by another request, which may have no deadline.
+    if (request_slots[slot].id != id) {
+        return;
+    }
+    auto request_promise = request.take(id);
+    if (!request_promise) {
+        return;
+    }
+    finish_request(slot, std::move(*request_promise), [](auto& promise) {
+        promise.set_exception(std::make_exception_ptr(std::system_error(std::make_error_code(std::errc::timed_out))));
+    });
+}
+
+void Client::fail_pending_requests(std::errc error)
+{
+    if (request.size() == 0) {
+        return;
+    }
+    request.take_all([this, error](std::uint32_t id, pc::promise<std::optional<protocol::ErrorResponseType>> promise) {
+        timing_wheel.cancel(request_slots[request.slot(id)].timer);
+        finish_request(request.slot(id), std::move(promise), [error](auto& promise) {
+            promise.set_exception(std::make_exception_ptr(std::system_error(std::make_error_code(error))));
+        });
+    });
 }
 
 void Client::impl_disconnect()
 {
+    if (state == ConnectionState::Connected) {
+        link_drops.fetch_add(1, std::memory_order_relaxed);
+    }
+    state = ConnectionState::Disconnected;
+    timing_wheel.cancel(ping_timer);
+    timing_wheel.cancel(handshake_timer);
+    handshake_permit.release();
+    fail_pending_requests(std::errc::connection_aborted);
+    // Ends a handshake in progress quietly; whoever disconnected decides whether to connect again, and the callers
+    // of async_connect() keep waiting for that.
+    auto aborted = std::make_exception_ptr(std::system_error(asio::error::operation_aborted));
+    if (hello_response_promise) {
+        auto promise = std::move(*hello_response_promise);
+        hello_response_promise.reset();
+        promise.set_exception(aborted);
+    }
+    if (pin_state_promise) {
+        auto promise = std::move(*pin_state_promise);
+        pin_state_promise.reset();
+        promise.set_exception(aborted);
+    }
     std::error_code ec;
     socket.close(ec);
     if (ec) {
-        std::cout << "Client::disconnect()" << ec << ": " << ec.message() << std::endl;
+        log_warning("client", "Client::disconnect(): ", ec);
     }
 }
 
@@ -9,17 +9,130 @@
 
 #include "protocol/command_handler.hpp"
 
+#include "client/command.hpp"
+#include "client/device_snapshot.hpp"
+#include "client/frame.hpp"
+#include "client/output_queue.hpp"
+#include "client/pin_state.hpp"
+#include "client/status_stream.hpp"
 #include "common/action_if_exists.hpp"
-
-#include <deque>
+#include "common/admission_limiter.hpp"
+#include "common/circular_queue.hpp"
+#include "common/device_id.hpp"
+#include "common/exponential_backoff.hpp"
+#include "common/mpsc_queue.hpp"
+#include "common/request_table.hpp"
+#include "common/ring_buffer.hpp"
+#include "common/rtt_estimator.hpp"
+#include "common/seq_lock.hpp"
+#include "common/serial_executor.hpp"
+#include "common/timing_wheel.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
 #include <optional>
 #include <type_traits>
 
 namespace tsvetkov {
 
+struct ClientOptions
+{
+    // Queued frames are gathered into one write (writev) up to these limits.
+    std::size_t max_write_frames = 64;
+    std::size_t max_write_bytes  = 64 * 1024;
+    // SO_SNDBUF of the connection; zero keeps the system default, which Linux tunes on its own.
+    int send_buffer_size = 0;
+    // Output queue lanes: interactive frames written per bulk frame, and the limit of queued frames per lane beyond
+    // which commands fail with std::errc::no_buffer_space. is_congested() turns on at 3/4 of it, off at 1/4.
+    std::size_t interactive_weight = 4;
+    std::size_t max_queued_frames  = 4096;
+    // Rewrite commands not yet written: a second inversion of a pin cancels the queued first one, all on / all off
+    // supersede the commands queued before them in the same lane. Elided commands complete with the effective result:
+    // a cancelled pair succeeds, a superseded command completes as the command that superseded it.
+    bool coalesce_commands = true;
+    // Size of the pending request table, rounded up to a power of two.
+    std::size_t max_pending_requests = 1024;
+    // A command without a reply after this long fails with std::errc::timed_out; zero disables the deadline.
+    std::chrono::steady_clock::duration request_timeout = std::chrono::seconds(5);
+    // Any inbound frame proves the link is alive; a ping is sent only after a whole `keepalive_idle` period without
+    // other traffic. An unanswered ping is repeated after the RTO estimated from earlier ping round trips, doubling
+    // each time, and the link is dropped once `keepalive_probes` pings in a row got no reply. Only the repeats follow
+    // the RTT: `keepalive_idle` is how long silence is tolerated, so it stays as configured.
+    std::chrono::steady_clock::duration keepalive_idle = std::chrono::seconds(1);
+    std::uint32_t keepalive_probes                     = 3;
+    std::chrono::steady_clock::duration initial_rto    = std::chrono::seconds(1);
+    std::chrono::steady_clock::duration min_rto        = std::chrono::milliseconds(200);
+    std::chrono::steady_clock::duration max_rto        = std::chrono::seconds(4);
+    // Reconnect attempts wait a random delay up to reconnect_initial_delay * 2^attempt, capped at reconnect_max_delay.
+    std::chrono::steady_clock::duration reconnect_initial_delay = std::chrono::milliseconds(500);
+    std::chrono::steady_clock::duration reconnect_max_delay     = std::chrono::seconds(30);
+    // Shared by the clients of a site to bound how many connect + hello + status handshakes run at once. Null admits
+    // every handshake immediately.
+    std::shared_ptr<AdmissionLimiter> handshake_limiter;
+    // A handshake that has not completed by then is abandoned and retried, so a silent device cannot hold a permit.
+    std::chrono::steady_clock::duration handshake_timeout = std::chrono::seconds(10);
+    // Refuse a device that reports another id than the one set with Client::set_expected_device(). Off only where a
+    // single stand-in device answers for a whole fleet.
+    bool verify_device_id = true;
+    // Receives the pins that changed with every status notification. Usually shared by all clients of a site.
+    std::shared_ptr<StatusStream> status_stream;
+};
+
+struct ClientStats
+{
+    std::uint64_t frames_written = 0;
+    std::uint64_t write_syscalls = 0;
+    // Writes the socket took only part of; the rest went out with the next write.
+    std::uint64_t partial_writes = 0;
+    // Commands encoded by the client's executor, the number of wakeups it took, and commands refused by a full lane.
+    std::uint64_t commands_drained  = 0;
+    std::uint64_t command_drains    = 0;
+    std::uint64_t commands_rejected = 0;
+    // Commands never written because a later command cancelled or superseded them.
+    std::uint64_t commands_coalesced = 0;
+    // Keepalive periods that ended with a ping, and those skipped because other traffic was flowing.
+    std::uint64_t pings_sent       = 0;
+    std::uint64_t pings_suppressed = 0;
+    // Ping round trip estimate, see RttEstimator.
+    std::uint64_t rtt_samples = 0;
+    std::chrono::steady_clock::duration srtt{};
+    std::chrono::steady_clock::duration rttvar{};
+    std::chrono::steady_clock::duration rto{};
+    // Established connections lost, other than by disconnect().
+    std::uint64_t link_drops = 0;
+    // Handshakes refused because the device reported another id than expected.
+    std::uint64_t wrong_devices = 0;
+
+    double frames_per_syscall() const
+    {
+        return write_syscalls == 0 ? 0.0 : static_cast<double>(frames_written) / static_cast<double>(write_syscalls);
+    }
+};
+
+enum class ConnectionState
+{
+    Disconnected,
+    Connecting,
+    Connected
+};
+
 struct Client : std::enable_shared_from_this<Client>
 {
-    Client(asio::io_context& io, const std::string& remote_address, std::uint16_t port);
+    Client(asio::io_context& io,
+           const std::string& remote_address,
+           std::uint16_t port,
+           ClientOptions options = ClientOptions{});
+
+    // Runs every handler of the client on `executor`, e.g. SerialExecutor::single_threaded() for an io_context
+    // driven by one thread.
+    Client(SerialExecutor executor,
+           const std::string& remote_address,
+           std::uint16_t port,
+           ClientOptions options = ClientOptions{});
+
+    ~Client();
 
     Client(const Client&) = delete;
     Client(Client&&)      = delete;
@@ -27,57 +140,105 @@ struct Client : std::enable_shared_from_this<Client>
     Client& operator=(const Client&) = delete;
     Client& operator=(Client&&) = delete;
 
-    pc::future<protocol::SmartPowerStatus> async_connect();
-    protocol::SmartPowerStatus connect();
+    // Ready with the pin state the device reported once connected.
+    pc::future<PinState> async_connect();
+    PinState connect();
 
+    // Ready once the connection is closed; the client stays disconnected until connected again.
+    pc::future<void> async_disconnect();
+    // Blocks until async_disconnect() is done, so must not be called from a thread that runs the client's executor.
     void disconnect();
 
+    using command_result_type = std::optional<protocol::ErrorResponseType>;
+    using timeout_type        = std::chrono::steady_clock::duration;
+
+    // Command futures fail with std::system_error: std::errc::timed_out once `timeout` (ClientOptions::request_timeout
+    // by default) passes without a reply, std::errc::connection_aborted when the connection drops first.
+    // Commands reach the device in the order they were submitted only within one lane: an interactive command may
+    // overtake bulk commands submitted before it, so a sequence whose order matters goes through a single lane.
+    pc::future<command_result_type> async_send_all_on();
+    pc::future<command_result_type> async_send_all_on(timeout_type timeout, Lane lane = Lane::Interactive);
+    pc::future<command_result_type> async_send_all_off();
+    pc::future<command_result_type> async_send_all_off(timeout_type timeout, Lane lane = Lane::Interactive);
+    pc::future<command_result_type> async_inversion(std::uint8_t pin);
+    pc::future<command_result_type> async_inversion(std::uint8_t pin,
+                                                    timeout_type timeout,
+                                                    Lane lane = Lane::Interactive);
+
     void send_all_on();
     void send_all_off();
 
     void inversion(std::uint8_t pin);
 
+    ConnectionState connection_state() const;
+    // Address the client connects to, fixed at construction.
+    std::string remote_address() const;
+
+    // Called on the client's executor with every status notification, including the one that completes each
+    // (re)connect. Set it before connecting.
+    using status_handler_type = std::function<void(const PinState&)>;
+    void set_status_handler(status_handler_type handler);
+
+    // The device the address is expected to reach, e.g. one remembered from an earlier discovery. If another device
+    // answers the handshake, it is disconnected and the connection retried later, while async_connect() keeps waiting.
+    // Set it before connecting.
+    void set_expected_device(DeviceId id);
+
+    // Latest reported state, readable from any thread without a lock or a post to the client's executor.
+    DeviceSnapshot snapshot() const;
+
+    // Backpressure: true while the interactive and bulk lanes hold many frames. Submitters of bulk traffic should
+    // hold off until it clears.
+    bool is_congested() const;
+
+    ClientStats stats() const;
+
 private:
-    template<typename F, typename... Args>
-    pc::future<std::optional<protocol::ErrorResponseType>> async_add_request(F&& f, Args... args)
-    {
-        pc::promise<std::optional<protocol::ErrorResponseType>> request_promise;
-        auto result = request_promise.get_future();
-        async_post(
-            action_if_exists(make_single_context(shared_from_this()),
-                             [f               = std::forward<F>(f),
-                              request_promise = std::move(request_promise),
-                              args = std::make_tuple<typename std::decay_t<Args>...>(std::forward<Args>(args)...)](
-                                 Client* self) mutable {
-                                 auto id = self->next_id();
-                                 self->request.emplace(std::piecewise_construct,
-                                                       std::forward_as_tuple(id),
-                                                       std::forward_as_tuple(std::move(request_promise)));
-                                 self->push_to_queue(std::apply(f, std::tuple_cat(std::tie(id), std::move(args))));
-                             }))
-            .detach();
-        return result;
-    }
+    // Callable from any thread: queues the command and wakes the client's executor unless a drain is already
+    // scheduled, so a burst of submissions costs one post.
+    pc::future<command_result_type> submit(Command::Type type, std::uint8_t pin, timeout_type timeout, Lane lane);
+    void update_congestion();
+    void drain_commands();
+    Frame encode(const Command& command, std::uint32_t id);
+    FrameEffect frame_effect(const Command& command) const;
+    void elide_request(std::uint32_t id, std::optional<std::uint32_t> superseded_by);
 
     void response(std::uint32_t id, std::optional<protocol::ErrorResponseType> error_response);
+    void start_request_deadline(std::uint32_t id, timeout_type timeout);
+    void on_request_deadline(std::size_t slot, std::uint32_t id);
+    void fail_pending_requests(std::errc error);
+
+    // Completes the request taken from `slot` and the commands it superseded alike.
+    template<typename F>
+    void finish_request(std::size_t slot, pc::promise<command_result_type> promise, F&& complete)
+    {
+        auto superseded = std::move(request_slots[slot].superseded);
+        request_slots[slot].superseded.clear();
+        complete(promise);
+        for (auto& superseded_promise : superseded) {
+            complete(superseded_promise);
+        }
+    }
 
     template<typename Buffer>
-    void push_to_queue(Buffer buffer)
+    void push_to_queue(const Buffer& buffer)
     {
-        output_buffer.emplace_back(buffer.begin(), buffer.end());
+        output_buffer.push(Lane::Control, Frame(buffer));
         async_write();
     }
 
     template<typename F>
     auto async_post(F f)
     {
-        return pc::async(client_strand, [f = std::forward<F>(f)]() mutable { f(); });
+        return pc::async(client_executor, [f = std::forward<F>(f)]() mutable { f(); });
     }
 
     void impl_async_connect();
+    void impl_handshake();
+    void on_handshake_timeout();
     template<typename F>
     void set_async_connect_result(F&& f){
-        std::vector<pc::promise<protocol::SmartPowerStatus>> temp_connections_to_client;
+        std::vector<pc::promise<PinState>> temp_connections_to_client;
         std::swap(connections_to_client, temp_connections_to_client);
         std::for_each(temp_connections_to_client.begin(), temp_connections_to_client.end(), std::forward<F>(f));
     }
@@ -85,11 +246,15 @@ private:
     void impl_disconnect();
 
     void send_hello_request();
-    void send_ping();
+    bool send_ping();
     void async_write();
+    void async_write_some();
+    bool consume_written(std::size_t bytes_transferred);
     void async_read();
 
-    void start_ping();
+    void start_ping(std::chrono::steady_clock::duration delay);
+    void on_ping_timer();
+    void on_ping_response();
     void reconnect();
 
     void system_error_filter(const std::system_error& error, std::function<void(Client*)> f){
@@ -101,34 +266,99 @@ private:
 
 
     std::uint32_t next_id();
+    std::optional<std::uint32_t> next_request_id();
+
+    using incoming_buffer_type = RingBuffer<4096>;
+
+    const ClientOptions options;
 
     asio::io_context& io_context;
-    asio::io_context::strand client_strand;
+    SerialExecutor client_executor;
+    TimingWheel& timing_wheel;
+    // Declared before the socket: a pending read targets this storage until the socket is closed.
+    incoming_buffer_type incoming_buffer;
     asio::ip::tcp::socket socket;
     asio::ip::tcp::endpoint endpoint;
 
-    std::chrono::steady_clock::time_point last_response_ping;
-    pc::future<void> ping_task;
+    // Keepalive, touched only on the client executor.
+    std::uint64_t inbound_frames         = 0;
+    std::uint64_t inbound_frames_at_tick = 0;
+    std::optional<std::uint32_t> ping_id;
+    std::chrono::steady_clock::time_point ping_sent_at;
+    // A ping was due since the last traffic or reply, whether or not it could be sent.
+    bool is_probing                = false;
+    bool is_ping_answered          = false;
+    std::uint32_t unanswered_pings = 0;
+    RttEstimator rtt;
+    TimerNode ping_timer;
+    TimerNode reconnect_timer;
+    TimerNode handshake_timer;
+    ExponentialBackoff reconnect_backoff;
+    AdmissionLimiter::Permit handshake_permit;
 
 
     // Connection task
     // step 1
     std::optional<pc::promise<protocol::HelloResponse>> hello_response_promise;
     // step 2
-    std::optional<pc::promise<protocol::SmartPowerStatus>> smart_power_status_promise;
+    std::optional<pc::promise<PinState>> pin_state_promise;
+
+    std::vector<pc::promise<PinState>> connections_to_client;
 
-    std::vector<pc::promise<protocol::SmartPowerStatus>> connections_to_client;
+    // Reported in HelloResponse.
+    DeviceId device_id = 0;
+    std::optional<DeviceId> expected_device;
+    // Pin state of the last status notification received from the device.
+    PinState pin_state;
+    std::uint64_t notifications = 0;
+    // Copy of the above for other threads, written only on the client executor.
+    SeqLock<DeviceSnapshot> latest;
+    status_handler_type status_handler;
 
-    bool is_connected = false;
+    std::atomic<ConnectionState> state{ConnectionState::Disconnected};
 
     std::uint32_t counter_id = 0;
 
-    std::string accumulate_incoming_buffer;
+    CommandPool command_pool;
+    MpscQueue<Command> submitted_commands;
+    std::atomic<bool> is_drain_scheduled{false};
 
     bool is_async_write = false;
-    std::deque<std::string> output_buffer;
-
-    std::unordered_map<std::uint32_t, pc::promise<std::optional<protocol::ErrorResponseType>>> request;
+    OutputQueue output_buffer;
+    std::atomic<bool> is_congested_flag{false};
+    // Frames of the write in flight and the not yet written part of them.
+    std::vector<Frame> writing_frames;
+    std::vector<asio::const_buffer> write_buffers;
+    std::size_t write_position = 0;
+
+    std::atomic<std::uint64_t> frames_written{0};
+    std::atomic<std::uint64_t> write_syscalls{0};
+    std::atomic<std::uint64_t> partial_writes{0};
+    std::atomic<std::uint64_t> commands_drained{0};
+    std::atomic<std::uint64_t> command_drains{0};
+    std::atomic<std::uint64_t> commands_rejected{0};
+    std::atomic<std::uint64_t> commands_coalesced{0};
+    std::atomic<std::uint64_t> link_drops{0};
+    std::atomic<std::uint64_t> wrong_devices{0};
+    std::atomic<std::uint64_t> pings_sent{0};
+    std::atomic<std::uint64_t> pings_suppressed{0};
+    std::atomic<std::uint64_t> rtt_samples{0};
+    std::atomic<std::chrono::steady_clock::rep> srtt{0};
+    std::atomic<std::chrono::steady_clock::rep> rttvar{0};
+    std::atomic<std::chrono::steady_clock::rep> rto{0};
+
+    RequestTable<pc::promise<std::optional<protocol::ErrorResponseType>>> request;
+
+    // Deadline of the request in the same slot of `request`, and the promises of the commands it superseded.
+    struct RequestSlot
+    {
+        TimerNode timer;
+        std::uint32_t id = 0;
+        // Request the timer was last armed for, read by the wheel when it fires.
+        std::atomic<std::uint32_t> armed_id{0};
+        std::vector<pc::promise<command_result_type>> superseded;
+    };
+    std::unique_ptr<RequestSlot[]> request_slots;
 
     protocol::CommandHandler commandHandler;
 };
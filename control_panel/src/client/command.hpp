@@ -0,0 +1,87 @@
+#pragma once
+
+#include "portable_concurrency/future"
+
+#include "protocol/command_handler.hpp"
+
+#include "client/output_queue.hpp"
+#include "common/bounded_mpmc_queue.hpp"
+#include "common/mpsc_queue.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+namespace tsvetkov {
+// A command submitted to a Client from any thread, queued until the client's executor encodes it. The request id
+// is only assigned then, so the command carries what to send rather than the frame.
+struct Command : MpscQueueNode
+{
+    enum class Type : std::uint8_t
+    {
+        AllOn,
+        AllOff,
+        Inversion
+    };
+
+    Type type        = Type::AllOn;
+    std::uint8_t pin = 0;
+    Lane lane        = Lane::Interactive;
+    std::chrono::steady_clock::duration timeout{};
+    pc::promise<std::optional<protocol::ErrorResponseType>> promise;
+};
+
+// Recycles the Command nodes of one Client: taken by submit() on any thread, given back on the client executor once
+// the command is queued or failed. The spare nodes sit in a bounded lock-free queue of `capacity` cells, so neither
+// side takes a lock; a node that finds the queue full is deleted, and an empty queue means a fresh allocation.
+// Only the node is recycled: the promise in it gets a new shared state for every command.
+class CommandPool
+{
+public:
+    struct Release
+    {
+        CommandPool* pool;
+
+        void operator()(Command* command) const
+        {
+            pool->release(command);
+        }
+    };
+    using handle_type = std::unique_ptr<Command, Release>;
+
+    explicit CommandPool(std::size_t capacity) : free_(capacity) {}
+
+    ~CommandPool()
+    {
+        while (auto command = free_.pop()) {
+            delete command;
+        }
+    }
+
+    CommandPool(const CommandPool&) = delete;
+    CommandPool& operator=(const CommandPool&) = delete;
+
+    // A node with a fresh promise.
+    handle_type acquire()
+    {
+        auto command = free_.pop();
+        if (command) {
+            command->promise = decltype(command->promise){};
+        } else {
+            command = new Command();
+        }
+        return handle_type(command, Release{this});
+    }
+
+    void release(Command* command)
+    {
+        if (!free_.push(command)) {
+            delete command;
+        }
+    }
+
+private:
+    BoundedMpmcQueue<Command> free_;
+};
+} // namespace tsvetkov
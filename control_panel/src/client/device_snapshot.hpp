@@ -0,0 +1,21 @@
+#pragma once
+
+#include "client/pin_state.hpp"
+#include "common/device_id.hpp"
+
+#include <chrono>
+#include <cstdint>
+
+namespace tsvetkov {
+// Latest reported state of one device, published through a SeqLock.
+struct DeviceSnapshot
+{
+    DeviceId device = 0;
+    PinState pin_state;
+    // Status notifications received; 0 until the device first reported.
+    std::uint64_t notifications = 0;
+    std::chrono::steady_clock::time_point updated_at;
+    // Set once the device reported (Client) or joined the pool (StatusBoard); false for a free StatusBoard slot.
+    bool is_present = false;
+};
+} // namespace tsvetkov
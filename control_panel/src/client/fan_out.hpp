@@ -0,0 +1,46 @@
+#pragma once
+
+#include "client/client.hpp"
+
+#include "portable_concurrency/future"
+
+#include <iterator>
+#include <vector>
+
+namespace tsvetkov {
+// Starts `command` on every client of [first, last) without waiting for any of them and returns a future that is
+// ready once all of them have completed. `command` is called with the dereferenced iterator and must return the
+// future of an async Client command, e.g. [](const auto& client) { return client->async_send_all_off(); }.
+// Individual results (or exceptions) stay in the returned futures.
+template<typename Iterator, typename F>
+pc::future<std::vector<pc::future<Client::command_result_type>>> fan_out(Iterator first, Iterator last, F&& command)
+{
+    std::vector<pc::future<Client::command_result_type>> futures;
+    futures.reserve(static_cast<std::size_t>(std::distance(first, last)));
+    for (; first != last; ++first) {
+        futures.push_back(command(*first));
+    }
+    return pc::when_all(std::make_move_iterator(futures.begin()), std::make_move_iterator(futures.end()));
+}
+
+template<typename Range, typename F>
+pc::future<std::vector<pc::future<Client::command_result_type>>> fan_out(Range& clients, F&& command)
+{
+    return fan_out(std::begin(clients), std::end(clients), std::forward<F>(command));
+}
+
+// Number of commands that completed with neither an exception nor an ErrorResponse.
+inline std::size_t count_succeeded(std::vector<pc::future<Client::command_result_type>>& results)
+{
+    std::size_t succeeded = 0;
+    for (auto& result : results) {
+        try {
+            if (!result.get()) {
+                ++succeeded;
+            }
+        } catch (const std::exception&) {
+        }
+    }
+    return succeeded;
+}
+} // namespace tsvetkov
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+
+namespace tsvetkov {
+// Outgoing packet with inline storage. Client commands are a few dozen bytes, so keeping them by value in the
+// output queue avoids a heap string per command.
+struct Frame
+{
+    static constexpr std::size_t max_size = 64;
+
+    Frame() = default;
+
+    template<typename Buffer>
+    explicit Frame(const Buffer& buffer)
+        : length(static_cast<std::size_t>(std::distance(std::begin(buffer), std::end(buffer))))
+    {
+        if (length > max_size) {
+            throw std::length_error("Frame: packet does not fit into the inline storage");
+        }
+        std::copy(std::begin(buffer), std::end(buffer), storage.begin());
+    }
+
+    const char* data() const
+    {
+        return storage.data();
+    }
+
+    std::size_t size() const
+    {
+        return length;
+    }
+
+    std::array<char, max_size> storage;
+    std::size_t length = 0;
+};
+} // namespace tsvetkov
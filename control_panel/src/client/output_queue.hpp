@@ -0,0 +1,229 @@
+#pragma once
+
+#include "client/frame.hpp"
+#include "common/circular_queue.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+namespace tsvetkov {
+enum class Lane : std::uint8_t
+{
+    // Handshake and keepalive frames: always written first, never rejected.
+    Control,
+    // Commands somebody is waiting on.
+    Interactive,
+    // Fleet-wide or scripted traffic.
+    Bulk
+};
+
+// What a queued command does to the strip, so that the unwritten part of a lane can be rewritten: a second toggle of
+// a pin cancels the first one, and setting every pin supersedes whatever was queued before it.
+enum class FrameEffect : std::uint8_t
+{
+    None,
+    Toggle,
+    SetAll
+};
+
+enum class PushResult : std::uint8_t
+{
+    Queued,
+    // Cancelled out a queued frame instead of being queued.
+    Cancelled,
+    // The lane is full.
+    Rejected
+};
+
+// Client output queue split into priority lanes. The control lane drains strictly first; the interactive and bulk
+// lanes share what is left, `interactive_weight` interactive frames per bulk frame while both have frames queued,
+// so bulk traffic can neither starve nor delay a heartbeat. Interactive and bulk lanes hold at most
+// `lane_capacity` frames each. Frames leave in the order they were pushed only within a lane; across lanes the
+// order is the scheduler's, and that is what lets interactive commands overtake a bulk backlog.
+//
+// Command frames pushed with an effect are coalesced with the frames queued before them in the same lane; frames
+// removed that way are left as tombstones and skipped, which keeps every operation O(1) amortized. Tombstones don't
+// count against `lane_capacity`.
+class OutputQueue
+{
+public:
+    OutputQueue(std::size_t lane_capacity, std::size_t interactive_weight)
+        : lane_capacity_(lane_capacity), interactive_weight_(std::max<std::size_t>(interactive_weight, 1))
+    {
+        for (auto& lane : lanes_) {
+            lane.toggles.fill(0);
+        }
+    }
+
+    // Returns false if the lane is full.
+    bool push(Lane lane, const Frame& frame)
+    {
+        auto ignore = [](std::uint32_t, std::optional<std::uint32_t>) {};
+        return push_command(lane, frame, FrameEffect::None, 0, 0, ignore) == PushResult::Queued;
+    }
+
+    // Queues the frame of request `id`. `elided(id, superseded_by)` is called for every queued request the frame
+    // makes redundant: `superseded_by` is `id` when the new frame overrides it, and empty when the two cancel out.
+    // A SetAll frame supersedes the queued frames even if it is then rejected because the lane is full.
+    template<typename F>
+    PushResult push_command(Lane lane,
+                            const Frame& frame,
+                            FrameEffect effect,
+                            std::uint8_t pin,
+                            std::uint32_t id,
+                            F&& elided)
+    {
+        auto& queue = lanes_[index(lane)];
+        if (effect == FrameEffect::Toggle && queue.toggles[pin] > queue.popped) {
+            auto& entry    = queue.at(queue.toggles[pin] - 1);
+            auto cancelled = entry.id;
+            entry.is_live  = false;
+            --queue.live;
+            queue.toggles[pin] = 0;
+            queue.trim();
+            elided(cancelled, std::nullopt);
+            return PushResult::Cancelled;
+        }
+        if (effect == FrameEffect::SetAll) {
+            for (auto position = std::max(queue.popped, queue.superseded); position < queue.end(); ++position) {
+                auto& entry = queue.at(position);
+                if (entry.is_live && entry.effect != FrameEffect::None) {
+                    entry.is_live = false;
+                    --queue.live;
+                    elided(entry.id, id);
+                }
+            }
+            queue.toggles.fill(0);
+            queue.trim();
+            queue.superseded = queue.end();
+        }
+        if (lane != Lane::Control && queue.live >= lane_capacity_) {
+            return PushResult::Rejected;
+        }
+        queue.entries.emplace_back(Entry{frame, effect, pin, id, true});
+        ++queue.live;
+        if (effect == FrameEffect::Toggle) {
+            queue.toggles[pin] = queue.end();
+        }
+        return PushResult::Queued;
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    std::size_t size() const
+    {
+        return lanes_[0].live + lanes_[1].live + lanes_[2].live;
+    }
+
+    std::size_t size(Lane lane) const
+    {
+        return lanes_[index(lane)].live;
+    }
+
+    // Next frame to write, !empty().
+    Frame& front()
+    {
+        return lanes_[index(select())].entries.front().frame;
+    }
+
+    void pop_front()
+    {
+        auto lane   = select();
+        auto& queue = lanes_[index(lane)];
+        queue.entries.pop_front();
+        ++queue.popped;
+        --queue.live;
+        queue.trim();
+        if (lane == Lane::Interactive) {
+            ++interactive_run_;
+        } else if (lane == Lane::Bulk) {
+            interactive_run_ = 0;
+        }
+    }
+
+    void clear()
+    {
+        for (auto& queue : lanes_) {
+            queue.popped += queue.entries.size();
+            queue.entries.clear();
+            queue.live = 0;
+        }
+        interactive_run_ = 0;
+    }
+
+private:
+    struct Entry
+    {
+        Frame frame;
+        FrameEffect effect = FrameEffect::None;
+        std::uint8_t pin   = 0;
+        std::uint32_t id   = 0;
+        bool is_live       = true;
+    };
+
+    // Positions are absolute, counted from the first push to the lane. Only tombstones trimmed off the back give their
+    // position up to the next push, and nothing refers to those.
+    struct LaneQueue
+    {
+        Entry& at(std::uint64_t position)
+        {
+            return entries[static_cast<std::size_t>(position - popped)];
+        }
+
+        std::uint64_t end() const
+        {
+            return popped + entries.size();
+        }
+
+        // Keeps a live entry (or nothing) at both ends.
+        void trim()
+        {
+            while (!entries.empty() && !entries.front().is_live) {
+                entries.pop_front();
+                ++popped;
+            }
+            while (!entries.empty() && !entries.back().is_live) {
+                entries.pop_back();
+            }
+        }
+
+        CircularQueue<Entry> entries;
+        std::size_t live = 0;
+        // Position of the first entry still in `entries`.
+        std::uint64_t popped = 0;
+        // Entries before this position were superseded by a SetAll already.
+        std::uint64_t superseded = 0;
+        // Position + 1 of the queued toggle of each pin after the last SetAll, 0 if none.
+        std::array<std::uint64_t, 256> toggles;
+    };
+
+    static std::size_t index(Lane lane)
+    {
+        return static_cast<std::size_t>(lane);
+    }
+
+    Lane select() const
+    {
+        if (lanes_[index(Lane::Control)].live != 0) {
+            return Lane::Control;
+        }
+        auto has_interactive = lanes_[index(Lane::Interactive)].live != 0;
+        auto has_bulk        = lanes_[index(Lane::Bulk)].live != 0;
+        if (has_interactive && has_bulk) {
+            return interactive_run_ < interactive_weight_ ? Lane::Interactive : Lane::Bulk;
+        }
+        return has_interactive ? Lane::Interactive : Lane::Bulk;
+    }
+
+    std::size_t lane_capacity_;
+    std::size_t interactive_weight_;
+    std::size_t interactive_run_ = 0;
+    std::array<LaneQueue, 3> lanes_;
+};
+} // namespace tsvetkov
@@ -0,0 +1,180 @@
+#pragma once
+
+#include "protocol/command_handler.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+namespace tsvetkov {
+// Set of pins 0..255 as four 64-bit words. Set operations and counting are a handful of AND/XOR/POPCNT
+// instructions, and arrays of masks scan without branches.
+class PinMask
+{
+public:
+    static constexpr std::size_t max_pins = 256;
+
+    bool test(std::uint8_t pin) const
+    {
+        return (words_[pin / 64] >> (pin % 64)) & 1u;
+    }
+
+    void set(std::uint8_t pin, bool value = true)
+    {
+        auto bit = std::uint64_t{1} << (pin % 64);
+        words_[pin / 64] = value ? words_[pin / 64] | bit : words_[pin / 64] & ~bit;
+    }
+
+    void reset(std::uint8_t pin)
+    {
+        set(pin, false);
+    }
+
+    void flip(std::uint8_t pin)
+    {
+        words_[pin / 64] ^= std::uint64_t{1} << (pin % 64);
+    }
+
+    std::size_t count() const
+    {
+        return static_cast<std::size_t>(__builtin_popcountll(words_[0]) + __builtin_popcountll(words_[1]) +
+                                        __builtin_popcountll(words_[2]) + __builtin_popcountll(words_[3]));
+    }
+
+    bool any() const
+    {
+        return (words_[0] | words_[1] | words_[2] | words_[3]) != 0;
+    }
+
+    bool none() const
+    {
+        return !any();
+    }
+
+    // Calls f(pin) for every pin of the set in ascending order.
+    template<typename F>
+    void for_each(F&& f) const
+    {
+        for (std::size_t word = 0; word < words_.size(); ++word) {
+            for (auto bits = words_[word]; bits != 0; bits &= bits - 1) {
+                f(static_cast<std::uint8_t>(word * 64 + static_cast<std::size_t>(__builtin_ctzll(bits))));
+            }
+        }
+    }
+
+    PinMask operator&(const PinMask& other) const
+    {
+        return combine(other, [](std::uint64_t a, std::uint64_t b) { return a & b; });
+    }
+
+    PinMask operator|(const PinMask& other) const
+    {
+        return combine(other, [](std::uint64_t a, std::uint64_t b) { return a | b; });
+    }
+
+    PinMask operator^(const PinMask& other) const
+    {
+        return combine(other, [](std::uint64_t a, std::uint64_t b) { return a ^ b; });
+    }
+
+    PinMask operator~() const
+    {
+        return combine(*this, [](std::uint64_t a, std::uint64_t) { return ~a; });
+    }
+
+    bool operator==(const PinMask& other) const
+    {
+        return words_ == other.words_;
+    }
+
+    bool operator!=(const PinMask& other) const
+    {
+        return !(*this == other);
+    }
+
+private:
+    template<typename Op>
+    PinMask combine(const PinMask& other, Op op) const
+    {
+        PinMask result;
+        for (std::size_t word = 0; word < words_.size(); ++word) {
+            result.words_[word] = op(words_[word], other.words_[word]);
+        }
+        return result;
+    }
+
+    std::array<std::uint64_t, 4> words_{};
+};
+
+// On/off state of the pins of a strip: the pins it has (or, for a desired state, the pins somebody cares about) and
+// which of them are on. 64 bytes, no allocation; protocol::SmartPowerStatus is converted once on arrival.
+struct PinState
+{
+    using Status = protocol::SmartPowerStatus::Status;
+
+    static PinState from_status(const protocol::SmartPowerStatus& status)
+    {
+        PinState result;
+        for (const auto& pair : status.status) {
+            result.set(pair.first, pair.second);
+        }
+        return result;
+    }
+
+    std::unordered_map<std::uint8_t, Status> to_map() const
+    {
+        std::unordered_map<std::uint8_t, Status> result;
+        present.for_each([&](std::uint8_t pin) { result.emplace(pin, status(pin)); });
+        return result;
+    }
+
+    bool has(std::uint8_t pin) const
+    {
+        return present.test(pin);
+    }
+
+    Status status(std::uint8_t pin) const
+    {
+        return on.test(pin) ? Status::On : Status::Off;
+    }
+
+    void set(std::uint8_t pin, Status status)
+    {
+        present.set(pin);
+        on.set(pin, status == Status::On);
+    }
+
+    std::size_t size() const
+    {
+        return present.count();
+    }
+
+    // Pins of `other` override ours.
+    void merge(const PinState& other)
+    {
+        on      = (on & ~other.present) | other.on;
+        present = present | other.present;
+    }
+
+    bool operator==(const PinState& other) const
+    {
+        return present == other.present && on == other.on;
+    }
+
+    bool operator!=(const PinState& other) const
+    {
+        return !(*this == other);
+    }
+
+    PinMask present;
+    // Subset of `present`.
+    PinMask on;
+};
+
+// Pins whose state differs: present in only one of the two, or on in one and off in the other.
+inline PinMask changed_pins(const PinState& a, const PinState& b)
+{
+    return (a.present ^ b.present) | (a.on ^ b.on);
+}
+} // namespace tsvetkov
@@ -0,0 +1,43 @@
+#include "status_stream.hpp"
+
+namespace tsvetkov {
+namespace {
+PinLevel level(const PinState& state, std::uint8_t pin)
+{
+    if (!state.has(pin)) {
+        return PinLevel::Absent;
+    }
+    return state.on.test(pin) ? PinLevel::On : PinLevel::Off;
+}
+} // namespace
+
+StatusStream::StatusStream(std::size_t capacity) : ring_(std::make_shared<BroadcastRing<PinChange>>(capacity)) {}
+
+StatusStream::Subscription StatusStream::subscribe() const
+{
+    return Subscription(ring_);
+}
+
+std::size_t StatusStream::publish(DeviceId device, const PinState& previous, const PinState& current)
+{
+    auto changed = changed_pins(previous, current);
+    if (changed.none()) {
+        return 0;
+    }
+    PinChange change;
+    change.device    = device;
+    change.timestamp = std::chrono::system_clock::now();
+    changed.for_each([&](std::uint8_t pin) {
+        change.pin       = pin;
+        change.old_level = level(previous, pin);
+        change.new_level = level(current, pin);
+        ring_->publish(change);
+    });
+    return changed.count();
+}
+
+std::uint64_t StatusStream::published() const
+{
+    return ring_->published();
+}
+} // namespace tsvetkov
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "client/pin_state.hpp"
+#include "common/broadcast_ring.hpp"
+#include "common/device_id.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <utility>
+
+namespace tsvetkov {
+enum class PinLevel : std::uint8_t
+{
+    // The strip did not report the pin (yet).
+    Absent,
+    Off,
+    On
+};
+
+// One pin of one device changed, as seen in consecutive status notifications.
+struct PinChange
+{
+    DeviceId device = 0;
+    std::chrono::system_clock::time_point timestamp;
+    std::uint8_t pin   = 0;
+    PinLevel old_level = PinLevel::Absent;
+    PinLevel new_level = PinLevel::Absent;
+};
+
+// Stream of pin changes of every client it is given to (ClientOptions::status_stream). Clients publish only the pins
+// that differ from the device's previous notification, from their own executors and without ever waiting for a
+// reader. Readers (UI, recorder, rules engine) each poll their own Subscription from any thread; one that falls
+// `capacity` changes behind loses the oldest ones and can tell from dropped().
+class StatusStream
+{
+public:
+    class Subscription
+    {
+    public:
+        std::optional<PinChange> poll()
+        {
+            return ring_->poll(cursor_);
+        }
+
+        // Calls f(const PinChange&) for up to `max` pending changes, returns how many.
+        template<typename F>
+        std::size_t drain(F&& f, std::size_t max = SIZE_MAX)
+        {
+            return ring_->drain(cursor_, std::forward<F>(f), max);
+        }
+
+        std::uint64_t dropped() const
+        {
+            return cursor_.dropped();
+        }
+
+    private:
+        friend class StatusStream;
+        explicit Subscription(std::shared_ptr<const BroadcastRing<PinChange>> ring)
+            : ring_(std::move(ring)), cursor_(ring_->subscribe())
+        {
+        }
+
+        std::shared_ptr<const BroadcastRing<PinChange>> ring_;
+        BroadcastRing<PinChange>::Cursor cursor_;
+    };
+
+    explicit StatusStream(std::size_t capacity = 64 * 1024);
+
+    // Sees the changes published from now on.
+    Subscription subscribe() const;
+
+    // Publishes one PinChange per pin that differs between the two states, returns how many.
+    std::size_t publish(DeviceId device, const PinState& previous, const PinState& current);
+
+    std::uint64_t published() const;
+
+private:
+    std::shared_ptr<BroadcastRing<PinChange>> ring_;
+};
+} // namespace tsvetkov
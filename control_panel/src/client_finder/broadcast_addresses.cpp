@@ -0,0 +1,43 @@
+#include "broadcast_addresses.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <arpa/inet.h>
+#include <ifaddrs.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#endif
+
+#include <algorithm>
+
+namespace tsvetkov {
+std::vector<asio::ip::address_v4> directed_broadcast_addresses(const std::vector<std::string>& interfaces)
+{
+    std::vector<asio::ip::address_v4> result;
+#if defined(__unix__) || defined(__APPLE__)
+    ifaddrs* list = nullptr;
+    if (getifaddrs(&list) != 0) {
+        return result;
+    }
+    for (auto it = list; it != nullptr; it = it->ifa_next) {
+        if (!it->ifa_addr || it->ifa_addr->sa_family != AF_INET || !it->ifa_broadaddr) {
+            continue;
+        }
+        if (!(it->ifa_flags & IFF_UP) || !(it->ifa_flags & IFF_BROADCAST) || (it->ifa_flags & IFF_LOOPBACK)) {
+            continue;
+        }
+        if (!interfaces.empty() && std::find(interfaces.begin(), interfaces.end(), it->ifa_name) == interfaces.end()) {
+            continue;
+        }
+        auto broadcast = reinterpret_cast<const sockaddr_in*>(it->ifa_broadaddr);
+        asio::ip::address_v4 address(ntohl(broadcast->sin_addr.s_addr));
+        if (std::find(result.begin(), result.end(), address) == result.end()) {
+            result.push_back(address);
+        }
+    }
+    freeifaddrs(list);
+#else
+    (void)interfaces;
+#endif
+    return result;
+}
+} // namespace tsvetkov
@@ -0,0 +1,12 @@
+#pragma once
+
+#include "asio.hpp"
+
+#include <string>
+#include <vector>
+
+namespace tsvetkov {
+// Subnet-directed broadcast addresses (e.g. 192.168.1.255) of the IPv4 interfaces that are up and can broadcast,
+// loopback excluded. Only the interfaces named in `interfaces` unless it is empty. Each address appears once.
+std::vector<asio::ip::address_v4> directed_broadcast_addresses(const std::vector<std::string>& interfaces);
+} // namespace tsvetkov
@@ -0,0 +1,31 @@
+#include "cidr_range.hpp"
+
+#include <charconv>
+#include <string>
+
+namespace tsvetkov {
+std::optional<CidrRange> parse_cidr_range(std::string_view text)
+{
+    auto slash                 = text.find('/');
+    unsigned int prefix_length = 32;
+    if (slash != std::string_view::npos) {
+        auto digits = text.substr(slash + 1);
+        auto result = std::from_chars(digits.data(), digits.data() + digits.size(), prefix_length);
+        if (digits.empty() || result.ec != std::errc() || result.ptr != digits.data() + digits.size() ||
+            prefix_length > 32) {
+            return std::nullopt;
+        }
+        text = text.substr(0, slash);
+    }
+    std::error_code ec;
+    auto address = asio::ip::make_address_v4(std::string(text), ec);
+    if (ec) {
+        return std::nullopt;
+    }
+    auto mask = prefix_length == 0 ? std::uint32_t(0) : ~std::uint32_t(0) << (32 - prefix_length);
+    CidrRange range;
+    range.network       = asio::ip::address_v4(address.to_uint() & mask);
+    range.prefix_length = static_cast<std::uint8_t>(prefix_length);
+    return range;
+}
+} // namespace tsvetkov
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "asio.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+namespace tsvetkov {
+// IPv4 block such as 10.20.0.0/16. Its hosts exclude the network and broadcast addresses, except in /31 and /32
+// blocks, which have none to spare.
+struct CidrRange
+{
+    asio::ip::address_v4 network;
+    std::uint8_t prefix_length = 32;
+
+    std::uint64_t host_count() const
+    {
+        auto size = std::uint64_t(1) << (32 - prefix_length);
+        return size > 2 ? size - 2 : size;
+    }
+
+    // i-th host, i < host_count().
+    asio::ip::address_v4 host(std::uint64_t i) const
+    {
+        auto first = network.to_uint() + (prefix_length < 31 ? 1 : 0);
+        return asio::ip::address_v4(static_cast<std::uint32_t>(first + i));
+    }
+};
+
+// "a.b.c.d/n", or a bare address as a /32. Host bits set in the address are cleared. Nothing on malformed input.
+std::optional<CidrRange> parse_cidr_range(std::string_view text);
+} // namespace tsvetkov
@@ -4,30 +4,98 @@
 
 #include "client_finder.hpp"
 
+#include "client_finder/broadcast_addresses.hpp"
 #include "common/action_if_exists.hpp"
+#include "common/logger.hpp"
 #include "common/pc_adapters.hpp"
 
-#include <iostream>
+#include <stdexcept>
 
 namespace tsvetkov {
-ClientFinder::ClientFinder(asio::io_context& io)
-    : io_context(io),
+namespace {
+std::vector<CidrRange> parse_sweep_ranges(const std::vector<std::string>& ranges)
+{
+    std::vector<CidrRange> result;
+    for (const auto& text : ranges) {
+        auto range = parse_cidr_range(text);
+        if (!range) {
+            throw std::invalid_argument("ClientFinder: not a CIDR range: " + text);
+        }
+        result.push_back(*range);
+    }
+    return result;
+}
+} // namespace
+
+ClientFinder::ClientFinder(asio::io_context& io, ClientFinderOptions options)
+    : options_(options),
+      io_context(io),
       client_finder_strand_(io),
-      broadcast_endpoint_(asio::ip::address_v4::broadcast(), 5500),
-      unicast_endpoint_(asio::ip::udp::v4(), 8000),
+      timing_wheel_(asio::use_service<TimingWheel>(io)),
+      broadcast_endpoint_(asio::ip::address_v4::broadcast(), options.broadcast_port),
+      unicast_endpoint_(asio::ip::udp::v4(), options.listen_port),
       broadcast_socket_(io, broadcast_endpoint_.protocol()),
       unicast_socket_(io, unicast_endpoint_),
-      msg_(std::make_shared<knock_knock_command_buffer_type>(protocol::make_knock_knock_command(0, 8000))),
-      receive_buffer_(std::make_shared<receive_buffer_type>())
+      msg_(std::make_shared<knock_knock_command_buffer_type>(
+          protocol::make_knock_knock_command(0, unicast_socket_.local_endpoint().port()))),
+      receive_batch_(options.receive_batch, options.datagram_size),
+      probe_schedule_(options.probe_initial_interval, options.probe_max_interval, options.probe_stable_rounds),
+      sweep_ranges_(parse_sweep_ranges(options.sweep_ranges)),
+      sweep_tokens_(options.sweep_rate, options.sweep_burst, std::chrono::steady_clock::now())
 {
     broadcast_socket_.set_option(asio::socket_base::broadcast(true));
+    unicast_socket_.non_blocking(true);
+    unicast_socket_.set_option(asio::socket_base::receive_buffer_size(options.receive_buffer_size));
+    // Linux usually reports twice the size asked for, bookkeeping included.
+    if (receive_buffer_size() < options.receive_buffer_size) {
+        log_warning("client_finder",
+                    "receive buffer is ",
+                    receive_buffer_size(),
+                    " bytes instead of ",
+                    options.receive_buffer_size,
+                    ", raise net.core.rmem_max");
+    }
+    next_send_timer_.set_callback([this] {
+        asio::post(client_finder_strand_,
+                   action_if_exists(weak_from_this(), [](ClientFinder* self) { self->impl_send_packet(); }));
+    });
+    sweep_timer_.set_callback([this] {
+        asio::post(client_finder_strand_,
+                   action_if_exists(weak_from_this(), [](ClientFinder* self) { self->sweep_step(); }));
+    });
     commandHandler_.subscribe([this](std::uint32_t, protocol::HelloResponse hello_response) {
-        auto it = found_devices_.emplace(hello_response.type_device,
-                                         hello_response.high_device_id,
-                                         hello_response.low_device_id,
-                                         sender_endpoint_.address().to_string());
-        if (it.second && found_new_device_) {
-            found_new_device_(*it.first);
+        auto address  = sender_endpoint_.address().to_v4();
+        auto sighting = devices_.see(make_device_id(hello_response.high_device_id, hello_response.low_device_id),
+                                     hello_response.type_device,
+                                     address,
+                                     std::chrono::steady_clock::now());
+        FoundDevice device(hello_response.type_device,
+                           hello_response.high_device_id,
+                           hello_response.low_device_id,
+                           address.to_string());
+        is_round_news_ = is_round_news_ || sighting.kind != SightingKind::Seen;
+        switch (sighting.kind) {
+        case SightingKind::New:
+            if (found_new_device_) {
+                found_new_device_(std::move(device));
+            }
+            break;
+        case SightingKind::AddressChanged:
+            log_info("client_finder",
+                     "device ",
+                     hello_response.high_device_id,
+                     ':',
+                     hello_response.low_device_id,
+                     " moved from ",
+                     sighting.previous_address.to_string(),
+                     " to ",
+                     device.ip_address);
+            if (address_changed_) {
+                address_changed_(std::move(device), sighting.previous_address.to_string());
+            }
+            break;
+        case SightingKind::Seen:
+            break;
         }
     });
 }
@@ -37,9 +105,22 @@ void ClientFinder::subscribe_to_found_new_device_event(found_new_device_type sub
     found_new_device_ = std::move(sub);
 }
 
+void ClientFinder::subscribe_to_address_changed_event(address_changed_type sub)
+{
+    address_changed_ = std::move(sub);
+}
+
+void ClientFinder::subscribe_to_device_expired_event(device_expired_type sub)
+{
+    device_expired_ = std::move(sub);
+}
+
 void ClientFinder::start()
 {
     async_post(action_if_exists(make_single_context(shared_from_this()), [](ClientFinder* self) {
+        if (self->is_stopped_) {
+            return;
+        }
         self->broadcast_socket_.bind(self->broadcast_endpoint_);
         self->async_read();
         self->impl_send_packet();
@@ -48,62 +129,222 @@ void ClientFinder::start()
 
 void ClientFinder::async_read()
 {
-    unicast_socket_.async_receive_from(asio::buffer(*receive_buffer_), sender_endpoint_, use_future)
+    unicast_socket_.async_wait(asio::socket_base::wait_read, use_future)
         .next(client_finder_strand_,
-              action_if_exists(make_single_context(shared_from_this()),
-                               [receive_buffer = receive_buffer_](ClientFinder* self, std::size_t size) {
-                                   std::cout << "Packet ok! " << size << std::endl;
-                                   auto ec = self->commandHandler_.parse(receive_buffer->data(), size);
-                                   if (ec) {
-                                       std::cout << "ClientFinder::async_read(): " << ec.message() << std::endl;
-                                   }
-                                   self->async_read();
-                               }))
+              action_if_exists(make_single_context(shared_from_this()), [](ClientFinder* self) {
+                  // Closing the socket ends the wait with an error, which skips this; a wait that ended just before
+                  // stop() still gets here.
+                  if (self->is_stopped_) {
+                      return;
+                  }
+                  self->receive_datagrams();
+                  self->async_read();
+              }))
         .detach();
 }
 
-void ClientFinder::impl_send_packet()
+// A broadcast makes every device of the site answer at once: take the answers by the batch until the socket is
+// drained, then wait for the next ones.
+void ClientFinder::receive_datagrams()
 {
-    auto single_ctx = make_single_context(shared_from_this());
-    broadcast_socket_.async_send_to(asio::buffer(*msg_), broadcast_endpoint_, use_future)
-        .next(client_finder_strand_,
-              action_if_exists(
-                  single_ctx,
-                  [single_ctx, msg = msg_](ClientFinder* self, std::size_t) {
-                      std::cout << "udp ok" << std::endl;
-                      auto timer = std::make_shared<asio::steady_timer>(self->io_context);
-                      timer->expires_from_now(std::chrono::seconds(5));
-                      self->next_send_task_ =
-                          timer->async_wait(use_future)
-                              .then([single_ctx, timer](pc::promise<void> complete, pc::future<void> future) {
-                                  if (!complete.is_awaiten()) {
-                                      return;
-                                  }
-                                  try {
-                                      future.get();
-                                      action_if_exists(single_ctx,
-                                                       [](ClientFinder* self) { self->impl_send_packet(); })();
-                                  } catch (const context_is_destroyed&) {
-                                      std::cout << "Client finder error: context is destroyed" << std::endl;
-                                  } catch (const std::exception& e) {
-                                      std::cout << "Client finder error: exception " << e.what() << std::endl;
-                                  }
-                              });
-                  }))
-        .then([](pc::future<void> f) {
-            try {
-                f.get();
-            } catch (const std::exception& e) {
-                std::cout << "Client finder error: " << e.what() << std::endl;
+    for (std::size_t batch = 0; batch < max_batches_per_wakeup; ++batch) {
+        std::error_code ec;
+        auto count = receive_batch_.receive(unicast_socket_, ec);
+        if (ec) {
+            if (ec != asio::error::would_block) {
+                log_warning("client_finder", "receive: ", ec);
             }
-        })
-        .detach();
+            return;
+        }
+        receive_batches_.fetch_add(1, std::memory_order_relaxed);
+        datagrams_received_.fetch_add(count, std::memory_order_relaxed);
+        log_trace("client_finder", "received ", count, " datagrams");
+        for (std::size_t i = 0; i < count; ++i) {
+            if (receive_batch_.is_truncated(i)) {
+                datagrams_truncated_.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            sender_endpoint_ = receive_batch_.sender(i);
+            if (auto parse_ec = commandHandler_.parse(receive_batch_.data(i), receive_batch_.length(i))) {
+                parse_errors_.fetch_add(1, std::memory_order_relaxed);
+                log_warning("client_finder", "async_read(): ", parse_ec);
+            }
+        }
+        if (count < receive_batch_.capacity()) {
+            return;
+        }
+    }
+}
+
+void ClientFinder::expire_devices()
+{
+    if (options_.device_ttl == std::chrono::steady_clock::duration::zero()) {
+        return;
+    }
+    devices_.expire(std::chrono::steady_clock::now() - options_.device_ttl, [this](const DeviceRegistry::Entry& entry) {
+        FoundDevice device(entry.type,
+                           static_cast<std::uint32_t>(entry.id >> 32),
+                           static_cast<std::uint32_t>(entry.id),
+                           entry.address.to_string());
+        log_info("client_finder", "device ", device.high_device_id, ':', device.low_device_id, " expired");
+        if (device_expired_) {
+            device_expired_(std::move(device));
+        }
+    });
+}
+
+bool ClientFinder::end_probe_round(std::chrono::steady_clock::time_point now)
+{
+    // Newly missing: answered the probe before last but neither of the two since. Counted once, by the round in
+    // which they fell silent; expire_devices() forgets them later.
+    auto missing = devices_.count_seen_between(probe_times_[2], probe_times_[1]);
+    if (missing > 0) {
+        log_info("client_finder", missing, " devices stopped answering");
+    }
+    auto is_news   = is_round_news_ || missing > 0;
+    is_round_news_ = false;
+    std::rotate(probe_times_.rbegin(), probe_times_.rbegin() + 1, probe_times_.rend());
+    probe_times_[0] = now;
+    return is_news;
+}
+
+void ClientFinder::impl_send_packet()
+{
+    if (is_stopped_) {
+        return;
+    }
+    auto now = std::chrono::steady_clock::now();
+    expire_devices();
+    auto delay = probe_schedule_.next(end_probe_round(now));
+    probe_rounds_.fetch_add(1, std::memory_order_relaxed);
+
+    if (sweep_ranges_.empty()) {
+        broadcast_knock();
+        log_trace("client_finder",
+                  "next KnockKnock in ",
+                  std::chrono::duration_cast<std::chrono::milliseconds>(delay).count(),
+                  " ms");
+        timing_wheel_.schedule(next_send_timer_, delay);
+        return;
+    }
+    sweep_range_       = 0;
+    sweep_host_        = 0;
+    sweep_started_     = now;
+    sweep_round_delay_ = delay;
+    sweep_step();
+}
+
+void ClientFinder::broadcast_knock()
+{
+    auto addresses = directed_broadcast_addresses(options_.interfaces);
+    if (addresses.empty()) {
+        addresses.push_back(asio::ip::address_v4::broadcast());
+    }
+    for (const auto& address : addresses) {
+        broadcast_socket_.async_send_to(
+            asio::buffer(*msg_), asio::ip::udp::endpoint(address, options_.broadcast_port), use_future)
+            .then([self = shared_from_this(), msg = msg_, address](pc::future<std::size_t> f) {
+                try {
+                    f.get();
+                } catch (const std::exception& e) {
+                    self->knocks_failed_.fetch_add(1, std::memory_order_relaxed);
+                    log_error("client_finder", "KnockKnock to ", address.to_string(), " failed: ", e.what());
+                }
+            })
+            .detach();
+    }
+    knocks_sent_.fetch_add(addresses.size(), std::memory_order_relaxed);
+    log_trace("client_finder", "KnockKnock to ", addresses.size(), " broadcast addresses");
+}
+
+// Sends the KnockKnocks the token bucket allows right away from the listening socket, whose port they carry, then
+// waits for the bucket to refill. Answers are read meanwhile like broadcast ones; nothing waits for them, so a sweep
+// keeps as many probes outstanding as its rate puts on the wire before the first answers are back.
+void ClientFinder::sweep_step()
+{
+    if (is_stopped_) {
+        return;
+    }
+    auto now           = std::chrono::steady_clock::now();
+    auto tokens        = sweep_tokens_.take(max_knocks_per_step, now);
+    std::size_t sent   = 0;
+    std::size_t failed = 0;
+    for (; tokens > 0 && sweep_range_ < sweep_ranges_.size(); --tokens) {
+        const auto& range = sweep_ranges_[sweep_range_];
+        std::error_code ec;
+        unicast_socket_.send_to(asio::buffer(*msg_),
+                                asio::ip::udp::endpoint(range.host(sweep_host_), options_.broadcast_port),
+                                0,
+                                ec);
+        if (ec == asio::error::would_block) {
+            // The send queue is full: retry this host with the next tokens.
+            break;
+        }
+        if (ec) {
+            ++failed;
+            log_trace("client_finder", "KnockKnock to ", range.host(sweep_host_).to_string(), " failed: ", ec);
+        } else {
+            ++sent;
+        }
+        if (++sweep_host_ == range.host_count()) {
+            ++sweep_range_;
+            sweep_host_ = 0;
+        }
+    }
+    sweep_tokens_.refund(tokens);
+    knocks_sent_.fetch_add(sent, std::memory_order_relaxed);
+    knocks_failed_.fetch_add(failed, std::memory_order_relaxed);
+
+    if (sweep_range_ < sweep_ranges_.size()) {
+        timing_wheel_.schedule(sweep_timer_, sweep_tokens_.time_until(max_knocks_per_step, now));
+        return;
+    }
+    log_debug("client_finder",
+              "swept ",
+              sweep_ranges_.size(),
+              " ranges in ",
+              std::chrono::duration_cast<std::chrono::milliseconds>(now - sweep_started_).count(),
+              " ms, next sweep in ",
+              std::chrono::duration_cast<std::chrono::milliseconds>(sweep_round_delay_).count(),
+              " ms");
+    timing_wheel_.schedule(next_send_timer_, sweep_round_delay_);
+}
+
+std::uint16_t ClientFinder::listen_port() const
+{
+    return unicast_socket_.local_endpoint().port();
+}
+
+int ClientFinder::receive_buffer_size() const
+{
+    asio::socket_base::receive_buffer_size option;
+    unicast_socket_.get_option(option);
+    return option.value();
+}
+
+ClientFinderStats ClientFinder::stats() const
+{
+    ClientFinderStats result;
+    result.datagrams_received  = datagrams_received_.load(std::memory_order_relaxed);
+    result.receive_batches     = receive_batches_.load(std::memory_order_relaxed);
+    result.datagrams_truncated = datagrams_truncated_.load(std::memory_order_relaxed);
+    result.parse_errors        = parse_errors_.load(std::memory_order_relaxed);
+    result.probe_rounds        = probe_rounds_.load(std::memory_order_relaxed);
+    result.knocks_sent         = knocks_sent_.load(std::memory_order_relaxed);
+    result.knocks_failed       = knocks_failed_.load(std::memory_order_relaxed);
+    return result;
 }
 
 void ClientFinder::stop()
 {
     async_post(action_if_exists(make_single_context(shared_from_this()), [](ClientFinder* self) {
-        self->broadcast_socket_.close();
+        // A timer that already fired has posted its probe; the flag ends it, and with it the re-arming.
+        self->is_stopped_ = true;
+        self->timing_wheel_.cancel(self->next_send_timer_);
+        self->timing_wheel_.cancel(self->sweep_timer_);
+        std::error_code ec;
+        self->broadcast_socket_.close(ec);
+        self->unicast_socket_.close(ec);
     })).detach();
 }
 
@@ -7,12 +7,22 @@
 #include "asio.hpp"
 #include "protocol/command_handler.hpp"
 
-#include "portable_concurrency/future"
+#include "client_finder/cidr_range.hpp"
+#include "client_finder/datagram_batch.hpp"
+#include "client_finder/device_registry.hpp"
+#include "client_finder/probe_schedule.hpp"
+#include "common/timing_wheel.hpp"
+#include "common/token_bucket.hpp"
 
-#include "boost/container_hash/hash.hpp"
+#include "portable_concurrency/future"
 
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <functional>
-#include <unordered_set>
+#include <string>
+#include <tuple>
+#include <vector>
 
 namespace tsvetkov {
 struct FoundDevice
@@ -36,41 +46,93 @@ struct FoundDevice
                std::tie(other.type_device, other.high_device_id, other.low_device_id, other.ip_address);
     }
 };
-} // namespace tsvetkov
-namespace std {
-template<>
-struct hash<tsvetkov::FoundDevice>
+
+struct ClientFinderOptions
 {
-    std::size_t operator()(const tsvetkov::FoundDevice& v) const
-    {
-        std::size_t seed = 0;
-        boost::hash_combine(seed, v.type_device);
-        boost::hash_combine(seed, v.high_device_id);
-        boost::hash_combine(seed, v.low_device_id);
-        boost::hash_combine(seed, v.ip_address);
-        return seed;
-    }
+    // Port the KnockKnock broadcast goes to, and local port the devices answer to; 0 picks a free one.
+    std::uint16_t broadcast_port = 5500;
+    std::uint16_t listen_port    = 8000;
+    // KnockKnock goes to the subnet-directed broadcast address of each of these interfaces, or of every IPv4
+    // interface that can broadcast if empty; to 255.255.255.255 if none is found.
+    std::vector<std::string> interfaces;
+    // Probe pace, see ProbeSchedule: every probe_initial_interval while rounds bring news, slowing down to
+    // probe_max_interval once probe_stable_rounds rounds in a row brought none.
+    std::chrono::steady_clock::duration probe_initial_interval = std::chrono::milliseconds(250);
+    std::chrono::steady_clock::duration probe_max_interval     = std::chrono::minutes(1);
+    std::size_t probe_stable_rounds                            = 4;
+    // For networks that filter broadcast: when set, each probe round sends the KnockKnock unicast to every host of
+    // these CIDR ranges ("10.20.0.0/16") instead, at most sweep_rate per second (no limit if zero) and sweep_burst at
+    // once; the probe pace counts from the end of a sweep. Answers are handled as broadcast ones. On a directly
+    // attached network each probe of an absent host waits for ARP, and the neighbour table
+    // (net.ipv4.neigh.default.gc_thresh3) bounds how many may wait at once: lower the rate if knocks_failed grows.
+    std::vector<std::string> sweep_ranges;
+    double sweep_rate  = 20000.0;
+    double sweep_burst = 512.0;
+    // SO_RCVBUF of the listening socket: room for the answers of a whole site arriving at once. The kernel caps it at
+    // net.core.rmem_max.
+    int receive_buffer_size = 4 * 1024 * 1024;
+    // Answers taken per recvmmsg call, and bytes kept of each; longer datagrams are dropped.
+    std::size_t receive_batch = 64;
+    std::size_t datagram_size = 512;
+    // A device that has not answered a KnockKnock for this long is forgotten and reported expired; zero keeps
+    // devices forever. Keep it several probe_max_interval long, or settled devices expire between probes.
+    std::chrono::steady_clock::duration device_ttl = std::chrono::minutes(5);
 };
-} // namespace std
-namespace tsvetkov {
+
+struct ClientFinderStats
+{
+    std::uint64_t datagrams_received = 0;
+    // recvmmsg calls that returned datagrams.
+    std::uint64_t receive_batches     = 0;
+    std::uint64_t datagrams_truncated = 0;
+    std::uint64_t parse_errors        = 0;
+    // Probe rounds, and KnockKnock datagrams sent in them (one per broadcast address or swept host).
+    std::uint64_t probe_rounds  = 0;
+    std::uint64_t knocks_sent   = 0;
+    std::uint64_t knocks_failed = 0;
+};
+
 class ClientFinder : public std::enable_shared_from_this<ClientFinder>
 {
 public:
-    explicit ClientFinder(asio::io_context& io);
+    // Throws std::invalid_argument if one of options.sweep_ranges is not a CIDR range.
+    explicit ClientFinder(asio::io_context& io, ClientFinderOptions options = ClientFinderOptions{});
 
     using found_new_device_type = std::function<void(FoundDevice)>;
+    // A known device answered from another address; the device carries the new one.
+    using address_changed_type = std::function<void(FoundDevice, std::string previous_ip_address)>;
+    using device_expired_type  = std::function<void(FoundDevice)>;
 
     void subscribe_to_found_new_device_event(found_new_device_type sub);
+    void subscribe_to_address_changed_event(address_changed_type sub);
+    void subscribe_to_device_expired_event(device_expired_type sub);
 
     void start();
+    // Final: stops probing and closes both sockets. Probes and reads already posted find the finder stopped and end.
+    // listen_port() and receive_buffer_size() ask the socket, so they are for before stop().
     void stop();
 
+    std::uint16_t listen_port() const;
+    // SO_RCVBUF as granted by the kernel.
+    int receive_buffer_size() const;
+    ClientFinderStats stats() const;
+
 private:
     using knock_knock_command_buffer_type = std::array<char, protocol::KnockKnock::packet_size>;
-    using receive_buffer_type             = std::array<char, 65507>;
+
+    // Datagrams handled per wakeup before the strand is given back to other work.
+    static constexpr std::size_t max_batches_per_wakeup = 16;
+    // Unicast KnockKnocks sent per turn of a sweep, burst permitting.
+    static constexpr std::size_t max_knocks_per_step = 1024;
 
     void impl_send_packet();
+    void broadcast_knock();
+    void sweep_step();
     void async_read();
+    void receive_datagrams();
+    void expire_devices();
+    // Whether the round that ends now brought news: devices found or moved, or devices gone missing.
+    bool end_probe_round(std::chrono::steady_clock::time_point now);
 
     template<typename F>
     auto async_post(F f)
@@ -78,18 +140,46 @@ private:
         return pc::async(client_finder_strand_, [f = std::forward<F>(f)]() mutable { f(); });
     }
 
+    const ClientFinderOptions options_;
+
     asio::io_context& io_context;
     asio::io_context::strand client_finder_strand_;
+    TimingWheel& timing_wheel_;
     asio::ip::udp::endpoint broadcast_endpoint_;
     asio::ip::udp::endpoint unicast_endpoint_;
     asio::ip::udp::endpoint sender_endpoint_;
     asio::ip::udp::socket broadcast_socket_;
     asio::ip::udp::socket unicast_socket_;
     std::shared_ptr<knock_knock_command_buffer_type> msg_;
-    std::shared_ptr<receive_buffer_type> receive_buffer_;
-    pc::future<void> next_send_task_;
+    DatagramBatch receive_batch_;
+    TimerNode next_send_timer_;
+    TimerNode sweep_timer_;
     protocol::CommandHandler commandHandler_;
     found_new_device_type found_new_device_;
-    std::unordered_set<FoundDevice> found_devices_;
+    address_changed_type address_changed_;
+    device_expired_type device_expired_;
+    DeviceRegistry devices_;
+    ProbeSchedule probe_schedule_;
+    // Send times of the last probes, the latest first.
+    std::array<std::chrono::steady_clock::time_point, 3> probe_times_{};
+    bool is_round_news_ = false;
+    // Set by stop(); read and written on the strand only.
+    bool is_stopped_ = false;
+
+    std::vector<CidrRange> sweep_ranges_;
+    TokenBucket sweep_tokens_;
+    // Next host of the sweep in progress, and when the round after it starts.
+    std::size_t sweep_range_  = 0;
+    std::uint64_t sweep_host_ = 0;
+    std::chrono::steady_clock::time_point sweep_started_;
+    std::chrono::steady_clock::duration sweep_round_delay_{};
+
+    std::atomic<std::uint64_t> datagrams_received_{0};
+    std::atomic<std::uint64_t> receive_batches_{0};
+    std::atomic<std::uint64_t> datagrams_truncated_{0};
+    std::atomic<std::uint64_t> parse_errors_{0};
+    std::atomic<std::uint64_t> probe_rounds_{0};
+    std::atomic<std::uint64_t> knocks_sent_{0};
+    std::atomic<std::uint64_t> knocks_failed_{0};
 };
 } // namespace tsvetkov
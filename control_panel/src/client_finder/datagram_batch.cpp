@@ -0,0 +1,73 @@
+#include "datagram_batch.hpp"
+
+#include <algorithm>
+#include <cerrno>
+
+namespace tsvetkov {
+DatagramBatch::DatagramBatch(std::size_t capacity, std::size_t datagram_size)
+    : capacity_(capacity),
+      datagram_size_(datagram_size),
+      buffers_(capacity * datagram_size),
+      senders_(capacity),
+      lengths_(capacity),
+      truncated_(capacity)
+{
+#ifdef __linux__
+    iovecs_.resize(capacity);
+    headers_.resize(capacity);
+    for (std::size_t i = 0; i < capacity; ++i) {
+        iovecs_[i].iov_base            = buffers_.data() + i * datagram_size;
+        iovecs_[i].iov_len             = datagram_size;
+        headers_[i].msg_hdr.msg_iov    = &iovecs_[i];
+        headers_[i].msg_hdr.msg_iovlen = 1;
+        headers_[i].msg_hdr.msg_name   = senders_[i].data();
+    }
+#endif
+}
+
+std::size_t DatagramBatch::receive(asio::ip::udp::socket& socket, std::error_code& ec)
+{
+    ec    = std::error_code();
+    size_ = 0;
+#ifdef __linux__
+    for (std::size_t i = 0; i < capacity_; ++i) {
+        headers_[i].msg_hdr.msg_namelen = static_cast<socklen_t>(senders_[i].capacity());
+        headers_[i].msg_hdr.msg_flags   = 0;
+    }
+    auto received = ::recvmmsg(socket.native_handle(),
+                               headers_.data(),
+                               static_cast<unsigned int>(capacity_),
+                               MSG_DONTWAIT,
+                               nullptr);
+    if (received < 0) {
+        ec = errno == EAGAIN || errno == EWOULDBLOCK ? make_error_code(asio::error::would_block)
+                                                     : std::error_code(errno, std::system_category());
+        return 0;
+    }
+    size_ = static_cast<std::size_t>(received);
+    for (std::size_t i = 0; i < size_; ++i) {
+        senders_[i].resize(headers_[i].msg_hdr.msg_namelen);
+        lengths_[i]   = std::min<std::size_t>(headers_[i].msg_len, datagram_size_);
+        truncated_[i] = (headers_[i].msg_hdr.msg_flags & MSG_TRUNC) != 0;
+    }
+#else
+    // A datagram longer than the buffer fails with message_size; its first bytes are still delivered.
+    socket.non_blocking(true, ec);
+    while (!ec && size_ < capacity_) {
+        auto length = socket.receive_from(
+            asio::buffer(buffers_.data() + size_ * datagram_size_, datagram_size_), senders_[size_], 0, ec);
+        if (ec && ec != asio::error::message_size) {
+            break;
+        }
+        lengths_[size_]   = length;
+        truncated_[size_] = ec == asio::error::message_size;
+        ec                = std::error_code();
+        ++size_;
+    }
+    if (size_ > 0) {
+        ec = std::error_code();
+    }
+#endif
+    return size_;
+}
+} // namespace tsvetkov
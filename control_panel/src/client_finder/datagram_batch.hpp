@@ -0,0 +1,75 @@
+#pragma once
+
+#include "asio.hpp"
+
+#ifdef __linux__
+#include <sys/socket.h>
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <system_error>
+#include <vector>
+
+namespace tsvetkov {
+// Receives the datagrams queued on a UDP socket in batches: on Linux one recvmmsg call fills up to `capacity`
+// buffers of `datagram_size` bytes, elsewhere each datagram takes a receive_from call. The buffers are allocated
+// once and reused by every batch.
+class DatagramBatch
+{
+public:
+    DatagramBatch(std::size_t capacity, std::size_t datagram_size);
+
+    DatagramBatch(const DatagramBatch&) = delete;
+    DatagramBatch& operator=(const DatagramBatch&) = delete;
+
+    // Takes up to capacity() datagrams already queued on the socket without waiting. Returns how many; 0 with
+    // asio::error::would_block in `ec` once the queue is empty.
+    std::size_t receive(asio::ip::udp::socket& socket, std::error_code& ec);
+
+    std::size_t capacity() const
+    {
+        return capacity_;
+    }
+
+    // Datagrams of the last receive().
+    std::size_t size() const
+    {
+        return size_;
+    }
+
+    const char* data(std::size_t i) const
+    {
+        return buffers_.data() + i * datagram_size_;
+    }
+
+    std::size_t length(std::size_t i) const
+    {
+        return lengths_[i];
+    }
+
+    const asio::ip::udp::endpoint& sender(std::size_t i) const
+    {
+        return senders_[i];
+    }
+
+    // Longer than datagram_size: only its first datagram_size bytes were kept.
+    bool is_truncated(std::size_t i) const
+    {
+        return truncated_[i] != 0;
+    }
+
+private:
+    const std::size_t capacity_;
+    const std::size_t datagram_size_;
+    std::vector<char> buffers_;
+    std::vector<asio::ip::udp::endpoint> senders_;
+    std::vector<std::size_t> lengths_;
+    std::vector<std::uint8_t> truncated_;
+#ifdef __linux__
+    std::vector<iovec> iovecs_;
+    std::vector<mmsghdr> headers_;
+#endif
+    std::size_t size_ = 0;
+};
+} // namespace tsvetkov
@@ -0,0 +1,203 @@
+#include "device_cache.hpp"
+
+#include "common/logger.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace tsvetkov {
+namespace {
+struct Header
+{
+    std::uint32_t magic        = 0;
+    std::uint16_t version      = 0;
+    std::uint16_t record_size  = 0;
+    std::uint32_t record_count = 0;
+    std::uint32_t reserved     = 0;
+};
+
+// "TSDC" as written on this machine; reads back byte-swapped on one of the other byte order.
+constexpr std::uint32_t cache_magic   = 0x54534443;
+constexpr std::uint16_t cache_version = 1;
+
+static_assert(sizeof(Header) == 16, "the file layout is fixed");
+static_assert(sizeof(DeviceCache::Record) == 24, "the file layout is fixed");
+
+bool parse(const char* data, std::size_t size, std::vector<DeviceCache::Record>& records)
+{
+    Header header;
+    if (size < sizeof(header)) {
+        return false;
+    }
+    std::memcpy(&header, data, sizeof(header));
+    if (header.magic != cache_magic || header.version != cache_version ||
+        header.record_size != sizeof(DeviceCache::Record) ||
+        size < sizeof(header) + std::size_t(header.record_count) * sizeof(DeviceCache::Record)) {
+        return false;
+    }
+    records.resize(header.record_count);
+    std::memcpy(records.data(), data + sizeof(header), records.size() * sizeof(DeviceCache::Record));
+    return true;
+}
+
+FoundDevice to_found_device(const DeviceCache::Record& record)
+{
+    return FoundDevice(static_cast<protocol::DeviceType>(record.type),
+                       static_cast<std::uint32_t>(record.id >> 32),
+                       static_cast<std::uint32_t>(record.id),
+                       asio::ip::address_v4(record.address).to_string());
+}
+} // namespace
+
+DeviceCache::DeviceCache(std::string path) : path_(std::move(path)) {}
+
+bool DeviceCache::load()
+{
+    std::vector<Record> records;
+    bool is_loaded = false;
+#if defined(__unix__) || defined(__APPLE__)
+    auto fd = ::open(path_.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        struct stat status;
+        if (::fstat(fd, &status) == 0 && status.st_size > 0) {
+            auto size    = static_cast<std::size_t>(status.st_size);
+            auto mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping != MAP_FAILED) {
+                is_loaded = parse(static_cast<const char*>(mapping), size, records);
+                ::munmap(mapping, size);
+            }
+        }
+        ::close(fd);
+    }
+#else
+    std::ifstream file(path_, std::ios::binary);
+    std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    is_loaded = parse(content.data(), content.size(), records);
+#endif
+    if (!is_loaded) {
+        records.clear();
+    }
+
+    std::lock_guard lock_guard(mutex_);
+    records_.clear();
+    for (const auto& record : records) {
+        records_[record.id] = record;
+    }
+    is_dirty_ = false;
+    log_debug("client_finder", "device cache ", path_, ": ", records_.size(), " devices");
+    return is_loaded;
+}
+
+bool DeviceCache::save()
+{
+    std::vector<Record> records;
+    {
+        std::lock_guard lock_guard(mutex_);
+        if (!is_dirty_) {
+            return true;
+        }
+        records.reserve(records_.size());
+        for (const auto& pair : records_) {
+            records.push_back(pair.second);
+        }
+        is_dirty_ = false;
+    }
+    Header header;
+    header.magic        = cache_magic;
+    header.version      = cache_version;
+    header.record_size  = sizeof(Record);
+    header.record_count = static_cast<std::uint32_t>(records.size());
+
+    auto temporary_path = path_ + ".tmp";
+    {
+        std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(records.data()),
+                   static_cast<std::streamsize>(records.size() * sizeof(Record)));
+        if (!file.flush()) {
+            log_warning("client_finder", "cannot write device cache ", temporary_path);
+            std::lock_guard lock_guard(mutex_);
+            is_dirty_ = true;
+            return false;
+        }
+    }
+    if (std::rename(temporary_path.c_str(), path_.c_str()) != 0) {
+        log_warning("client_finder", "cannot replace device cache ", path_);
+        std::lock_guard lock_guard(mutex_);
+        is_dirty_ = true;
+        return false;
+    }
+    return true;
+}
+
+void DeviceCache::update(const FoundDevice& device, clock_type::time_point seen)
+{
+    std::error_code ec;
+    auto address = asio::ip::make_address_v4(device.ip_address, ec);
+    if (ec) {
+        return;
+    }
+    Record record;
+    record.id        = make_device_id(device.high_device_id, device.low_device_id);
+    record.last_seen = std::chrono::duration_cast<std::chrono::seconds>(seen.time_since_epoch()).count();
+    record.address   = address.to_uint();
+    record.type      = static_cast<std::uint8_t>(device.type_device);
+
+    std::lock_guard lock_guard(mutex_);
+    auto it = records_.find(record.id);
+    // Seen again within the same second at the same address: nothing to write.
+    if (it != records_.end() && it->second.address == record.address && it->second.type == record.type &&
+        it->second.last_seen == record.last_seen) {
+        return;
+    }
+    records_[record.id] = record;
+    is_dirty_           = true;
+}
+
+bool DeviceCache::remove(DeviceId id)
+{
+    std::lock_guard lock_guard(mutex_);
+    if (records_.erase(id) == 0) {
+        return false;
+    }
+    is_dirty_ = true;
+    return true;
+}
+
+std::vector<FoundDevice> DeviceCache::devices() const
+{
+    std::vector<Record> records;
+    {
+        std::lock_guard lock_guard(mutex_);
+        records.reserve(records_.size());
+        for (const auto& pair : records_) {
+            records.push_back(pair.second);
+        }
+    }
+    std::sort(records.begin(), records.end(), [](const Record& lhs, const Record& rhs) {
+        return lhs.last_seen != rhs.last_seen ? lhs.last_seen > rhs.last_seen : lhs.id < rhs.id;
+    });
+    std::vector<FoundDevice> result;
+    result.reserve(records.size());
+    for (const auto& record : records) {
+        result.push_back(to_found_device(record));
+    }
+    return result;
+}
+
+std::size_t DeviceCache::size() const
+{
+    std::lock_guard lock_guard(mutex_);
+    return records_.size();
+}
+} // namespace tsvetkov
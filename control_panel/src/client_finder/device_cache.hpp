@@ -0,0 +1,61 @@
+#pragma once
+
+#include "client_finder/client_finder.hpp"
+#include "common/device_id.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace tsvetkov {
+// Devices found by earlier runs and their last addresses, kept on disk so that a restart can connect to them before
+// discovery answers. The file is a 16-byte header and one 24-byte record per device, in native byte order: it is
+// read through a read-only mmap and written whole to a temporary file renamed over the old one, so a crash leaves
+// either. A file of another version, byte order or record size, or a truncated one, is ignored. Thread-safe.
+class DeviceCache
+{
+public:
+    using clock_type = std::chrono::system_clock;
+
+    struct Record
+    {
+        DeviceId id = 0;
+        // Seconds since the epoch.
+        std::int64_t last_seen = 0;
+        std::uint32_t address  = 0;
+        std::uint8_t type      = 0;
+        std::uint8_t reserved[3]{};
+    };
+
+    explicit DeviceCache(std::string path);
+
+    // Replaces the cached devices with those of the file. False if it is missing or unusable; the cache is then
+    // empty.
+    bool load();
+    // Writes the file if a device changed since the last load() or save(). False if writing failed.
+    bool save();
+
+    void update(const FoundDevice& device, clock_type::time_point seen = clock_type::now());
+    bool remove(DeviceId id);
+
+    // Most recently seen first.
+    std::vector<FoundDevice> devices() const;
+    std::size_t size() const;
+
+    const std::string& path() const
+    {
+        return path_;
+    }
+
+private:
+    const std::string path_;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<DeviceId, Record> records_;
+    bool is_dirty_ = false;
+};
+} // namespace tsvetkov
@@ -0,0 +1,107 @@
+#include "device_registry.hpp"
+
+#include <algorithm>
+
+namespace tsvetkov {
+namespace {
+std::size_t round_up(std::size_t n)
+{
+    std::size_t result = 2;
+    while (result < n) {
+        result <<= 1;
+    }
+    return result;
+}
+} // namespace
+
+DeviceRegistry::DeviceRegistry(std::size_t initial_capacity)
+    : entries_(round_up(initial_capacity)), mask_(entries_.size() - 1)
+{
+}
+
+Sighting DeviceRegistry::see(DeviceId id,
+                             protocol::DeviceType type,
+                             asio::ip::address_v4 address,
+                             clock_type::time_point now)
+{
+    auto slot = probe(id);
+    if (!entries_[slot].is_used) {
+        if (2 * (size_ + 1) > entries_.size()) {
+            grow();
+            slot = probe(id);
+        }
+        entries_[slot] = Entry{id, address, type, true, now};
+        ++size_;
+        return Sighting{SightingKind::New, asio::ip::address_v4()};
+    }
+    auto& entry     = entries_[slot];
+    auto previous   = entry.address;
+    entry.address   = address;
+    entry.type      = type;
+    entry.last_seen = now;
+    if (previous != address) {
+        return Sighting{SightingKind::AddressChanged, previous};
+    }
+    return Sighting{SightingKind::Seen, asio::ip::address_v4()};
+}
+
+const DeviceRegistry::Entry* DeviceRegistry::find(DeviceId id) const
+{
+    const auto& entry = entries_[probe(id)];
+    return entry.is_used ? &entry : nullptr;
+}
+
+bool DeviceRegistry::remove(DeviceId id)
+{
+    auto slot = probe(id);
+    if (!entries_[slot].is_used) {
+        return false;
+    }
+    erase_at(slot);
+    return true;
+}
+
+std::size_t DeviceRegistry::count_seen_between(clock_type::time_point from, clock_type::time_point to) const
+{
+    return static_cast<std::size_t>(std::count_if(entries_.begin(), entries_.end(), [&](const Entry& entry) {
+        return entry.is_used && entry.last_seen >= from && entry.last_seen < to;
+    }));
+}
+
+std::size_t DeviceRegistry::probe(DeviceId id) const
+{
+    auto slot = home(id);
+    while (entries_[slot].is_used && entries_[slot].id != id) {
+        slot = (slot + 1) & mask_;
+    }
+    return slot;
+}
+
+void DeviceRegistry::erase_at(std::size_t slot)
+{
+    auto hole = slot;
+    for (auto next = (hole + 1) & mask_; entries_[next].is_used; next = (next + 1) & mask_) {
+        // An entry may fill the hole unless its home lies between the hole and itself.
+        auto distance_from_home = (next - home(entries_[next].id)) & mask_;
+        auto distance_from_hole = (next - hole) & mask_;
+        if (distance_from_home >= distance_from_hole) {
+            entries_[hole] = entries_[next];
+            hole           = next;
+        }
+    }
+    entries_[hole].is_used = false;
+    --size_;
+}
+
+void DeviceRegistry::grow()
+{
+    std::vector<Entry> entries(entries_.size() * 2);
+    std::swap(entries, entries_);
+    mask_ = entries_.size() - 1;
+    for (const auto& entry : entries) {
+        if (entry.is_used) {
+            entries_[probe(entry.id)] = entry;
+        }
+    }
+}
+} // namespace tsvetkov
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "asio.hpp"
+#include "protocol/command_handler.hpp"
+
+#include "common/device_id.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+namespace tsvetkov {
+enum class SightingKind
+{
+    New,
+    Seen,
+    // Known device answering from another address.
+    AddressChanged
+};
+
+struct Sighting
+{
+    SightingKind kind;
+    // Before an AddressChanged sighting.
+    asio::ip::address_v4 previous_address;
+};
+
+// Devices that answered discovery, keyed by device id. One flat array of 24-byte entries, open addressing with linear
+// probing, at most half full. Removal shifts the entries behind back into the hole instead of leaving a tombstone,
+// so lookups stay short however many devices come and go. Not thread-safe.
+class DeviceRegistry
+{
+public:
+    using clock_type = std::chrono::steady_clock;
+
+    struct Entry
+    {
+        DeviceId id = 0;
+        asio::ip::address_v4 address;
+        protocol::DeviceType type{};
+        bool is_used = false;
+        clock_type::time_point last_seen;
+    };
+
+    explicit DeviceRegistry(std::size_t initial_capacity = 64);
+
+    // Records an answer of the device at `now`.
+    Sighting see(DeviceId id, protocol::DeviceType type, asio::ip::address_v4 address, clock_type::time_point now);
+
+    const Entry* find(DeviceId id) const;
+    bool remove(DeviceId id);
+
+    std::size_t size() const
+    {
+        return size_;
+    }
+
+    // Devices last seen in [from, to).
+    std::size_t count_seen_between(clock_type::time_point from, clock_type::time_point to) const;
+
+    // Removes the devices last seen before `seen_before`, calling on_expired(const Entry&) for each. Returns how many.
+    template<typename F>
+    std::size_t expire(clock_type::time_point seen_before, F&& on_expired)
+    {
+        std::size_t count = 0;
+        // Erasing shifts later entries back into slot i: look at it again.
+        for (std::size_t i = 0; i < entries_.size();) {
+            if (entries_[i].is_used && entries_[i].last_seen < seen_before) {
+                auto expired = entries_[i];
+                erase_at(i);
+                on_expired(static_cast<const Entry&>(expired));
+                ++count;
+            } else {
+                ++i;
+            }
+        }
+        return count;
+    }
+
+private:
+    std::size_t home(DeviceId id) const
+    {
+        return static_cast<std::size_t>(hash_device_id(id)) & mask_;
+    }
+
+    // Slot holding `id`, or the empty slot where it would go.
+    std::size_t probe(DeviceId id) const;
+    void erase_at(std::size_t slot);
+    void grow();
+
+    std::vector<Entry> entries_;
+    std::size_t mask_;
+    std::size_t size_ = 0;
+};
+} // namespace tsvetkov
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+
+namespace tsvetkov {
+// Pace of the discovery probes. Probes go out every `initial` while each round brings news: devices found, moved or
+// gone missing. After `stable_rounds` rounds in a row without news the interval doubles with every round, up to
+// `max`. Any news brings back the fast pace, so a cold start or a site coming back converges in a few initial
+// intervals while a settled site costs one broadcast per `max`.
+class ProbeSchedule
+{
+public:
+    using duration_type = std::chrono::steady_clock::duration;
+
+    ProbeSchedule(duration_type initial, duration_type max, std::size_t stable_rounds)
+        : initial_(initial), max_(std::max(initial, max)), stable_rounds_(stable_rounds), interval_(initial)
+    {
+    }
+
+    // Delay until the next probe, given whether the round that just ended brought news.
+    duration_type next(bool is_news)
+    {
+        if (is_news) {
+            quiet_rounds_ = 0;
+            interval_     = initial_;
+        } else if (++quiet_rounds_ >= stable_rounds_) {
+            interval_ = std::min(interval_ * 2, max_);
+        }
+        return interval_;
+    }
+
+    duration_type interval() const
+    {
+        return interval_;
+    }
+
+    std::size_t quiet_rounds() const
+    {
+        return quiet_rounds_;
+    }
+
+private:
+    duration_type initial_;
+    duration_type max_;
+    std::size_t stable_rounds_;
+    duration_type interval_;
+    std::size_t quiet_rounds_ = 0;
+};
+} // namespace tsvetkov
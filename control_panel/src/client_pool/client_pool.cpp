@@ -0,0 +1,177 @@
+#include "client_pool.hpp"
+
+#include "client/fan_out.hpp"
+#include "common/logger.hpp"
+
+#include <algorithm>
+
+namespace tsvetkov {
+ClientPool::ClientPool(asio::io_context& io, std::uint16_t port, ClientOptions options)
+    : io_context_(&io), port_(port), options_(options)
+{
+}
+
+ClientPool::ClientPool(ShardedRuntime& runtime, std::uint16_t port, ClientOptions options)
+    : runtime_(&runtime), port_(port), options_(options)
+{
+}
+
+SerialExecutor ClientPool::executor_for(DeviceId id)
+{
+    return runtime_ ? runtime_->executor_for(id) : SerialExecutor::strand(*io_context_);
+}
+
+std::shared_ptr<Client> ClientPool::add(const FoundDevice& device)
+{
+    auto id = make_device_id(device.high_device_id, device.low_device_id);
+    std::shared_ptr<Client> client;
+    {
+        std::lock_guard lock_guard(mutex_);
+        auto it = clients_.find(id);
+        if (it != clients_.end()) {
+            return it->second;
+        }
+        client = std::make_shared<Client>(executor_for(id), device.ip_address, port_, options_);
+        // The address may be a cached one that another strip has taken over since.
+        client->set_expected_device(id);
+        auto slot = status_board_.acquire(id);
+        // The client owns the handler, so it refers to the client by a plain pointer.
+        client->set_status_handler([id, slot, board = &status_board_, raw_client = client.get(),
+                                    handlers = status_handlers_](const PinState& state) {
+            auto snapshot   = raw_client->snapshot();
+            snapshot.device = id;
+            board->store(slot, snapshot);
+            for (const auto& handler : handlers) {
+                handler(id, state);
+            }
+        });
+        clients_.emplace(id, client);
+        board_slots_.emplace(id, slot);
+    }
+    client->async_connect().detach();
+    return client;
+}
+
+std::shared_ptr<Client> ClientPool::add_or_move(const FoundDevice& device)
+{
+    auto id = make_device_id(device.high_device_id, device.low_device_id);
+    if (auto client = find(id); client && client->remote_address() != device.ip_address) {
+        log_info("client_pool",
+                 "device ",
+                 device.high_device_id,
+                 ':',
+                 device.low_device_id,
+                 " moved from ",
+                 client->remote_address(),
+                 " to ",
+                 device.ip_address);
+        remove(id).detach();
+    }
+    return add(device);
+}
+
+pc::future<bool> ClientPool::remove(DeviceId id)
+{
+    std::shared_ptr<Client> client;
+    std::size_t slot;
+    {
+        std::lock_guard lock_guard(mutex_);
+        auto it = clients_.find(id);
+        if (it == clients_.end()) {
+            return pc::make_ready_future(false);
+        }
+        client = std::move(it->second);
+        clients_.erase(it);
+        slot = board_slots_.at(id);
+        board_slots_.erase(id);
+    }
+    return client->async_disconnect().next([this, id, slot] {
+        std::vector<removal_handler_type> handlers;
+        {
+            // Disconnected, the client no longer writes to its slot.
+            std::lock_guard lock_guard(mutex_);
+            status_board_.release(slot);
+            if (clients_.count(id) == 0) {
+                handlers = removal_handlers_;
+            }
+        }
+        for (const auto& handler : handlers) {
+            handler(id);
+        }
+        return true;
+    });
+}
+
+std::shared_ptr<Client> ClientPool::find(DeviceId id) const
+{
+    std::lock_guard lock_guard(mutex_);
+    auto it = clients_.find(id);
+    return it == clients_.end() ? nullptr : it->second;
+}
+
+std::vector<std::shared_ptr<Client>> ClientPool::clients() const
+{
+    std::vector<std::shared_ptr<Client>> result;
+    std::lock_guard lock_guard(mutex_);
+    result.reserve(clients_.size());
+    for (const auto& pair : clients_) {
+        result.push_back(pair.second);
+    }
+    return result;
+}
+
+std::size_t ClientPool::size() const
+{
+    std::lock_guard lock_guard(mutex_);
+    return clients_.size();
+}
+
+std::size_t ClientPool::count(ConnectionState state) const
+{
+    std::lock_guard lock_guard(mutex_);
+    return static_cast<std::size_t>(std::count_if(clients_.begin(), clients_.end(), [state](const auto& pair) {
+        return pair.second->connection_state() == state;
+    }));
+}
+
+std::vector<std::pair<DeviceId, ConnectionState>> ClientPool::connection_states() const
+{
+    std::vector<std::pair<DeviceId, ConnectionState>> result;
+    std::lock_guard lock_guard(mutex_);
+    result.reserve(clients_.size());
+    for (const auto& pair : clients_) {
+        result.emplace_back(pair.first, pair.second->connection_state());
+    }
+    return result;
+}
+
+void ClientPool::add_status_handler(status_handler_type handler)
+{
+    std::lock_guard lock_guard(mutex_);
+    status_handlers_.push_back(std::move(handler));
+}
+
+void ClientPool::add_removal_handler(removal_handler_type handler)
+{
+    std::lock_guard lock_guard(mutex_);
+    removal_handlers_.push_back(std::move(handler));
+}
+
+pc::future<ClientPool::results_type> ClientPool::async_all_on()
+{
+    auto targets = clients();
+    return fan_out(targets, [](const std::shared_ptr<Client>& client) { return client->async_send_all_on(); });
+}
+
+pc::future<ClientPool::results_type> ClientPool::async_all_off()
+{
+    auto targets = clients();
+    return fan_out(targets, [](const std::shared_ptr<Client>& client) { return client->async_send_all_off(); });
+}
+
+pc::future<ClientPool::results_type> ClientPool::async_inversion(std::uint8_t pin)
+{
+    auto targets = clients();
+    return fan_out(targets, [pin](const std::shared_ptr<Client>& client) { return client->async_inversion(pin); });
+}
+} // namespace tsvetkov
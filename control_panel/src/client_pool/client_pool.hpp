@@ -0,0 +1,88 @@
+#pragma once
+
+#include "asio.hpp"
+#include "portable_concurrency/future"
+
+#include "client/client.hpp"
+#include "client_finder/client_finder.hpp"
+#include "client_pool/status_board.hpp"
+#include "common/device_id.hpp"
+#include "runtime/sharded_runtime.hpp"
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace tsvetkov {
+// Owns the Client connections of a site, keyed by device id. All clients share one io_context, or are spread over the
+// shards of a ShardedRuntime by device id. Lookup is a single hash probe; broadcast commands are fanned out to every
+// client without waiting on any of them.
+class ClientPool
+{
+public:
+    using results_type = std::vector<pc::future<Client::command_result_type>>;
+
+    ClientPool(asio::io_context& io, std::uint16_t port, ClientOptions options = ClientOptions{});
+    ClientPool(ShardedRuntime& runtime, std::uint16_t port, ClientOptions options = ClientOptions{});
+
+    ClientPool(const ClientPool&) = delete;
+    ClientPool& operator=(const ClientPool&) = delete;
+
+    // Creates a client for the device and starts connecting. Returns the existing client if the device is known. The
+    // client only connects to the device with this id, see Client::set_expected_device().
+    std::shared_ptr<Client> add(const FoundDevice& device);
+    // Like add(), but a known device at another address gets a new client connecting there: discovery correcting
+    // a cached address, or a device that moved.
+    std::shared_ptr<Client> add_or_move(const FoundDevice& device);
+    // Drops the client at once and disconnects it without waiting, so it may be called from an io thread. The future
+    // is ready with false for an unknown device, otherwise with true once the client is disconnected; detach() it
+    // rather than dropping it, so its status board slot is still released. The pool must outlive the disconnect.
+    pc::future<bool> remove(DeviceId id);
+
+    std::shared_ptr<Client> find(DeviceId id) const;
+    std::vector<std::shared_ptr<Client>> clients() const;
+
+    std::size_t size() const;
+    std::size_t count(ConnectionState state) const;
+    std::vector<std::pair<DeviceId, ConnectionState>> connection_states() const;
+
+    // Called for clients added afterwards, in the order the handlers were added. See Client::set_status_handler.
+    using status_handler_type = std::function<void(DeviceId, const PinState&)>;
+    void add_status_handler(status_handler_type handler);
+
+    // Called once a removed client is disconnected, so no status handler runs for the device after it. Not called
+    // when the device was added again in the meantime, as add_or_move() does. Runs on the client's executor.
+    using removal_handler_type = std::function<void(DeviceId)>;
+    void add_removal_handler(removal_handler_type handler);
+
+    // Latest state of every device of the pool, readable from any thread without a lock: for_each(f) visits a
+    // consistent snapshot of each device. A device's entry is updated after its client's snapshot and before the
+    // status handlers run.
+    const StatusBoard& status_board() const
+    {
+        return status_board_;
+    }
+
+    pc::future<results_type> async_all_on();
+    pc::future<results_type> async_all_off();
+    pc::future<results_type> async_inversion(std::uint8_t pin);
+
+private:
+    SerialExecutor executor_for(DeviceId id);
+
+    asio::io_context* io_context_ = nullptr;
+    ShardedRuntime* runtime_      = nullptr;
+    std::uint16_t port_;
+    ClientOptions options_;
+    // Declared before the clients, which write to it.
+    StatusBoard status_board_;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<DeviceId, std::shared_ptr<Client>> clients_;
+    std::unordered_map<DeviceId, std::size_t> board_slots_;
+    std::vector<status_handler_type> status_handlers_;
+    std::vector<removal_handler_type> removal_handlers_;
+};
+} // namespace tsvetkov
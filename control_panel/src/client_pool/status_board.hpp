@@ -0,0 +1,102 @@
+#pragma once
+
+#include "client/device_snapshot.hpp"
+#include "common/device_id.hpp"
+#include "common/seq_lock.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+namespace tsvetkov {
+// Snapshots of every device of a pool, one SeqLock slot per device, readable from any thread without a lock: the
+// slots live in fixed-size chunks that never move, and a reader only looks at as many slots as were published when
+// it started. Each slot is written by the executor of its device; acquire() and release() are serialized by the
+// caller, and a slot is released only once its device can no longer write to it.
+class StatusBoard
+{
+public:
+    static constexpr std::size_t chunk_size = 1024;
+    static constexpr std::size_t max_chunks = 1024;
+
+    StatusBoard() = default;
+
+    StatusBoard(const StatusBoard&) = delete;
+    StatusBoard& operator=(const StatusBoard&) = delete;
+
+    ~StatusBoard()
+    {
+        for (auto& chunk : chunks_) {
+            delete chunk.load(std::memory_order_relaxed);
+        }
+    }
+
+    // Reserves a slot for the device, reusing released ones.
+    std::size_t acquire(DeviceId device)
+    {
+        std::size_t slot;
+        if (!free_slots_.empty()) {
+            slot = free_slots_.back();
+            free_slots_.pop_back();
+        } else {
+            slot = slots_.load(std::memory_order_relaxed);
+            if (slot / chunk_size >= max_chunks) {
+                throw std::length_error("StatusBoard: too many devices");
+            }
+            auto& chunk = chunks_[slot / chunk_size];
+            if (!chunk.load(std::memory_order_relaxed)) {
+                chunk.store(new Chunk(), std::memory_order_release);
+            }
+            slots_.store(slot + 1, std::memory_order_release);
+        }
+        DeviceSnapshot snapshot;
+        snapshot.device     = device;
+        snapshot.is_present = true;
+        at(slot).store(snapshot);
+        return slot;
+    }
+
+    void release(std::size_t slot)
+    {
+        at(slot).store(DeviceSnapshot{});
+        free_slots_.push_back(slot);
+    }
+
+    void store(std::size_t slot, const DeviceSnapshot& snapshot)
+    {
+        at(slot).store(snapshot);
+    }
+
+    DeviceSnapshot load(std::size_t slot) const
+    {
+        return at(slot).load();
+    }
+
+    // Calls f(const DeviceSnapshot&) for every present device.
+    template<typename F>
+    void for_each(F&& f) const
+    {
+        auto slots = slots_.load(std::memory_order_acquire);
+        for (std::size_t slot = 0; slot < slots; ++slot) {
+            auto snapshot = at(slot).load();
+            if (snapshot.is_present) {
+                f(snapshot);
+            }
+        }
+    }
+
+private:
+    using Chunk = std::array<SeqLock<DeviceSnapshot>, chunk_size>;
+
+    SeqLock<DeviceSnapshot>& at(std::size_t slot) const
+    {
+        return (*chunks_[slot / chunk_size].load(std::memory_order_acquire))[slot % chunk_size];
+    }
+
+    std::array<std::atomic<Chunk*>, max_chunks> chunks_{};
+    std::atomic<std::size_t> slots_{0};
+    std::vector<std::size_t> free_slots_;
+};
+} // namespace tsvetkov
@@ -0,0 +1,114 @@
+#include "admission_limiter.hpp"
+
+#include <algorithm>
+
+namespace tsvetkov {
+AdmissionLimiter::Permit& AdmissionLimiter::Permit::operator=(Permit&& other) noexcept
+{
+    if (this != &other) {
+        release();
+        limiter_ = std::move(other.limiter_);
+    }
+    return *this;
+}
+
+AdmissionLimiter::Permit::~Permit()
+{
+    release();
+}
+
+void AdmissionLimiter::Permit::release()
+{
+    if (limiter_) {
+        auto limiter = std::move(limiter_);
+        limiter->release();
+    }
+}
+
+AdmissionLimiter::AdmissionLimiter(asio::io_context& io, Options options)
+    : options_(options),
+      timer_(io),
+      tokens_(options.rate, options.burst, clock_type::now())
+{
+}
+
+std::shared_ptr<AdmissionLimiter> AdmissionLimiter::create(asio::io_context& io, Options options)
+{
+    return std::make_shared<AdmissionLimiter>(io, options);
+}
+
+void AdmissionLimiter::acquire(granted_type granted)
+{
+    {
+        std::lock_guard lock_guard(mutex_);
+        waiters_.push_back(std::move(granted));
+    }
+    grant();
+}
+
+std::size_t AdmissionLimiter::in_flight() const
+{
+    std::lock_guard lock_guard(mutex_);
+    return in_flight_;
+}
+
+std::size_t AdmissionLimiter::waiting() const
+{
+    std::lock_guard lock_guard(mutex_);
+    return waiters_.size();
+}
+
+void AdmissionLimiter::release()
+{
+    {
+        std::lock_guard lock_guard(mutex_);
+        --in_flight_;
+    }
+    grant();
+}
+
+// Grants are handed out one at a time outside the lock: a callback may acquire or release again.
+void AdmissionLimiter::grant()
+{
+    while (true) {
+        granted_type granted;
+        {
+            std::lock_guard lock_guard(mutex_);
+            if (waiters_.empty() || in_flight_ >= std::max<std::size_t>(options_.max_concurrent, 1)) {
+                return;
+            }
+            auto now = clock_type::now();
+            if (tokens_.take(1, now) == 0) {
+                arm(now);
+                return;
+            }
+            ++in_flight_;
+            granted = std::move(waiters_.front());
+            waiters_.pop_front();
+        }
+        granted(Permit(shared_from_this()));
+    }
+}
+
+void AdmissionLimiter::arm(clock_type::time_point now)
+{
+    if (is_armed_) {
+        return;
+    }
+    is_armed_ = true;
+    timer_.expires_at(now + tokens_.time_until(1, now));
+    timer_.async_wait([weak_self = weak_from_this()](const std::error_code& ec) {
+        auto self = weak_self.lock();
+        if (!self) {
+            return;
+        }
+        {
+            std::lock_guard lock_guard(self->mutex_);
+            self->is_armed_ = false;
+        }
+        if (!ec) {
+            self->grant();
+        }
+    });
+}
+} // namespace tsvetkov
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "asio.hpp"
+
+#include "common/token_bucket.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+namespace tsvetkov {
+// Admission control for expensive operations started by many independent objects, e.g. the connect + hello + status
+// handshake of every Client of a site after a power blip. A permit is granted when a token is available (token
+// bucket: `rate` per second, up to `burst` saved) and fewer than `max_concurrent` permits are held. Waiters are
+// served in FIFO order. Thread-safe. Create with create(): permits keep the limiter alive.
+class AdmissionLimiter : public std::enable_shared_from_this<AdmissionLimiter>
+{
+public:
+    struct Options
+    {
+        std::size_t max_concurrent = 32;
+        double rate                = 100.0;
+        double burst               = 32.0;
+    };
+
+    // Returned to the limiter when destroyed.
+    class Permit
+    {
+    public:
+        Permit() = default;
+        Permit(Permit&& other) noexcept = default;
+        Permit& operator=(Permit&& other) noexcept;
+        ~Permit();
+
+        explicit operator bool() const
+        {
+            return static_cast<bool>(limiter_);
+        }
+
+        void release();
+
+    private:
+        friend class AdmissionLimiter;
+        explicit Permit(std::shared_ptr<AdmissionLimiter> limiter) : limiter_(std::move(limiter)) {}
+
+        std::shared_ptr<AdmissionLimiter> limiter_;
+    };
+
+    using granted_type = std::function<void(Permit)>;
+
+    AdmissionLimiter(asio::io_context& io, Options options);
+
+    static std::shared_ptr<AdmissionLimiter> create(asio::io_context& io, Options options);
+
+    // `granted` is called once a permit is available, from within acquire(), a permit's release or the refill timer
+    // on the io_context, so it must be cheap and thread-agnostic: post the actual work to its owner's executor.
+    void acquire(granted_type granted);
+
+    std::size_t in_flight() const;
+    std::size_t waiting() const;
+
+private:
+    using clock_type = std::chrono::steady_clock;
+
+    void release();
+    void grant();
+    void arm(clock_type::time_point now);
+
+    const Options options_;
+    asio::steady_timer timer_;
+
+    mutable std::mutex mutex_;
+    TokenBucket tokens_;
+    std::size_t in_flight_ = 0;
+    bool is_armed_         = false;
+    std::deque<granted_type> waiters_;
+};
+} // namespace tsvetkov
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace tsvetkov {
+// Bounded multi-producer multi-consumer queue of pointers (D. Vyukov). Every cell carries a sequence number that
+// tells whose turn it is: a push claims a cell whose sequence equals its position, a pop one whose sequence is one
+// past it. Positions only grow, so a cell that was popped and pushed again in between is never mistaken for the
+// one a thread looked at: no ABA, unlike an intrusive lock-free stack. push() fails when the queue is full and
+// pop() returns nullptr when it is empty; neither allocates or blocks. The capacity is rounded up to a power of two.
+template<typename T>
+class BoundedMpmcQueue
+{
+public:
+    explicit BoundedMpmcQueue(std::size_t capacity)
+        : mask_(round_up(capacity) - 1), cells_(std::make_unique<Cell[]>(mask_ + 1))
+    {
+        for (std::size_t i = 0; i <= mask_; ++i) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    BoundedMpmcQueue(const BoundedMpmcQueue&) = delete;
+    BoundedMpmcQueue& operator=(const BoundedMpmcQueue&) = delete;
+
+    std::size_t capacity() const
+    {
+        return mask_ + 1;
+    }
+
+    bool push(T* element)
+    {
+        auto position = push_position_.load(std::memory_order_relaxed);
+        Cell* cell    = nullptr;
+        for (;;) {
+            cell          = &cells_[position & mask_];
+            auto sequence = cell->sequence.load(std::memory_order_acquire);
+            auto lag      = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position);
+            if (lag == 0) {
+                if (push_position_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (lag < 0) {
+                // the cell still holds the element pushed a lap ago
+                return false;
+            } else {
+                position = push_position_.load(std::memory_order_relaxed);
+            }
+        }
+        cell->element = element;
+        cell->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    T* pop()
+    {
+        auto position = pop_position_.load(std::memory_order_relaxed);
+        Cell* cell    = nullptr;
+        for (;;) {
+            cell          = &cells_[position & mask_];
+            auto sequence = cell->sequence.load(std::memory_order_acquire);
+            auto lag      = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position + 1);
+            if (lag == 0) {
+                if (pop_position_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (lag < 0) {
+                // nothing pushed into this cell yet
+                return nullptr;
+            } else {
+                position = pop_position_.load(std::memory_order_relaxed);
+            }
+        }
+        auto element = cell->element;
+        cell->sequence.store(position + mask_ + 1, std::memory_order_release);
+        return element;
+    }
+
+private:
+    struct Cell
+    {
+        std::atomic<std::size_t> sequence{0};
+        T* element = nullptr;
+    };
+
+    static std::size_t round_up(std::size_t capacity)
+    {
+        std::size_t result = 1;
+        while (result < capacity) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    const std::size_t mask_;
+    std::unique_ptr<Cell[]> cells_;
+    alignas(64) std::atomic<std::size_t> push_position_{0};
+    alignas(64) std::atomic<std::size_t> pop_position_{0};
+};
+} // namespace tsvetkov
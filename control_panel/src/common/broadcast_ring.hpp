@@ -0,0 +1,165 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <type_traits>
+
+namespace tsvetkov {
+// Fixed-size ring broadcasting every published element to any number of readers, each with its own cursor.
+// Publishing never waits for readers: a reader that falls a whole ring behind finds its elements overwritten, skips
+// ahead and is told how many it lost. Producers claim slots with one fetch_add and only ever wait for a producer
+// a full lap ahead of them to finish its copy. Slots are seqlocks: the sequence is odd while a slot is written, and
+// a reader keeps a copy only if the sequence did not move while it read. T must be trivially copyable; it is stored
+// in relaxed atomic words, so concurrent reads and writes are race-free.
+template<typename T>
+class BroadcastRing
+{
+    static_assert(std::is_trivially_copyable_v<T>, "BroadcastRing elements are copied word by word");
+
+public:
+    // Read position of one reader. Not thread-safe: one cursor per reading thread.
+    class Cursor
+    {
+    public:
+        // Elements overwritten before this reader got to them.
+        std::uint64_t dropped() const
+        {
+            return dropped_;
+        }
+
+    private:
+        friend class BroadcastRing;
+        explicit Cursor(std::uint64_t next) : next_(next) {}
+
+        std::uint64_t next_;
+        std::uint64_t dropped_ = 0;
+    };
+
+    explicit BroadcastRing(std::size_t capacity)
+        : capacity_(round_up(capacity)), mask_(capacity_ - 1), slots_(std::make_unique<Slot[]>(capacity_))
+    {
+    }
+
+    BroadcastRing(const BroadcastRing&) = delete;
+    BroadcastRing& operator=(const BroadcastRing&) = delete;
+
+    std::size_t capacity() const
+    {
+        return capacity_;
+    }
+
+    // Elements published so far.
+    std::uint64_t published() const
+    {
+        return head_.load(std::memory_order_acquire);
+    }
+
+    void publish(const T& element)
+    {
+        auto ticket = head_.fetch_add(1, std::memory_order_acq_rel);
+        auto& slot  = slots_[ticket & mask_];
+        // The previous lap's producer of this slot must be done copying.
+        auto previous = ticket >= capacity_ ? 2 * (ticket - capacity_) + 2 : 0;
+        while (slot.sequence.load(std::memory_order_acquire) != previous) {
+            std::this_thread::yield();
+        }
+        slot.sequence.store(2 * ticket + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        std::array<std::uint64_t, word_count> buffer{};
+        std::memcpy(buffer.data(), &element, sizeof(T));
+        for (std::size_t i = 0; i < word_count; ++i) {
+            slot.words[i].store(buffer[i], std::memory_order_relaxed);
+        }
+        slot.sequence.store(2 * ticket + 2, std::memory_order_release);
+    }
+
+    // A cursor at the next element to be published.
+    Cursor subscribe() const
+    {
+        return Cursor(published());
+    }
+
+    // Next element for `cursor`, or nothing if it is up to date (or the next element is still being copied).
+    std::optional<T> poll(Cursor& cursor) const
+    {
+        while (true) {
+            auto& slot    = slots_[cursor.next_ & mask_];
+            auto expected = 2 * cursor.next_ + 2;
+            auto before   = slot.sequence.load(std::memory_order_acquire);
+            if (before < expected) {
+                return std::nullopt;
+            }
+            if (before == expected) {
+                std::array<std::uint64_t, word_count> buffer;
+                for (std::size_t i = 0; i < word_count; ++i) {
+                    buffer[i] = slot.words[i].load(std::memory_order_relaxed);
+                }
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (slot.sequence.load(std::memory_order_relaxed) == expected) {
+                    ++cursor.next_;
+                    T element;
+                    std::memcpy(static_cast<void*>(&element), buffer.data(), sizeof(T));
+                    return element;
+                }
+            }
+            skip_ahead(cursor);
+        }
+    }
+
+    // Calls f(element) for up to `max` available elements, returns how many.
+    template<typename F>
+    std::size_t drain(Cursor& cursor, F&& f, std::size_t max = SIZE_MAX) const
+    {
+        std::size_t count = 0;
+        for (; count < max; ++count) {
+            auto element = poll(cursor);
+            if (!element) {
+                break;
+            }
+            f(*element);
+        }
+        return count;
+    }
+
+private:
+    static constexpr std::size_t word_count = (sizeof(T) + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t);
+
+    struct alignas(64) Slot
+    {
+        std::atomic<std::uint64_t> sequence{0};
+        std::array<std::atomic<std::uint64_t>, word_count> words{};
+    };
+
+    static std::size_t round_up(std::size_t n)
+    {
+        std::size_t result = 2;
+        while (result < n) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    // Lapped: resume half a ring behind the producers, so the reader is not overrun again right away.
+    void skip_ahead(Cursor& cursor) const
+    {
+        auto head   = published();
+        auto resume = head > capacity_ / 2 ? head - capacity_ / 2 : 0;
+        resume      = std::max(resume, cursor.next_ + 1);
+        cursor.dropped_ += resume - cursor.next_;
+        cursor.next_ = resume;
+    }
+
+    const std::size_t capacity_;
+    const std::size_t mask_;
+    std::unique_ptr<Slot[]> slots_;
+    alignas(64) std::atomic<std::uint64_t> head_{0};
+};
+} // namespace tsvetkov
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace tsvetkov {
+// FIFO over a power-of-two ring of preconstructed elements. It only allocates when it has to grow, so a queue that
+// has reached its working size pushes and pops without touching the heap. T must be default constructible and
+// move assignable; popped elements are left in place and overwritten by later pushes.
+template<typename T>
+class CircularQueue
+{
+public:
+    explicit CircularQueue(std::size_t initial_capacity = 16) : storage_(round_up(initial_capacity)) {}
+
+    std::size_t size() const
+    {
+        return tail_ - head_;
+    }
+
+    bool empty() const
+    {
+        return head_ == tail_;
+    }
+
+    std::size_t capacity() const
+    {
+        return storage_.size();
+    }
+
+    template<typename... Args>
+    T& emplace_back(Args&&... args)
+    {
+        if (size() == storage_.size()) {
+            grow();
+        }
+        auto& item = storage_[tail_ & mask()];
+        item       = T(std::forward<Args>(args)...);
+        ++tail_;
+        return item;
+    }
+
+    T& front()
+    {
+        return storage_[head_ & mask()];
+    }
+
+    T& back()
+    {
+        return storage_[(tail_ - 1) & mask()];
+    }
+
+    T& operator[](std::size_t i)
+    {
+        return storage_[(head_ + i) & mask()];
+    }
+
+    void pop_front()
+    {
+        ++head_;
+    }
+
+    void pop_back()
+    {
+        --tail_;
+    }
+
+    void clear()
+    {
+        head_ = 0;
+        tail_ = 0;
+    }
+
+private:
+    static std::size_t round_up(std::size_t n)
+    {
+        std::size_t result = 1;
+        while (result < n) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    std::size_t mask() const
+    {
+        return storage_.size() - 1;
+    }
+
+    void grow()
+    {
+        std::vector<T> storage(storage_.size() * 2);
+        for (std::size_t i = 0; i < size(); ++i) {
+            storage[i] = std::move((*this)[i]);
+        }
+        tail_ = size();
+        head_ = 0;
+        storage_.swap(storage);
+    }
+
+    std::vector<T> storage_;
+    std::size_t head_ = 0;
+    std::size_t tail_ = 0;
+};
+} // namespace tsvetkov
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+
+namespace tsvetkov {
+// Device id as reported in HelloResponse, high and low halves packed into one integer.
+using DeviceId = std::uint64_t;
+
+inline DeviceId make_device_id(std::uint32_t high_device_id, std::uint32_t low_device_id)
+{
+    return (static_cast<DeviceId>(high_device_id) << 32) | low_device_id;
+}
+
+// splitmix64 finalizer: device ids are often sequential, spread them evenly over shards and hash buckets.
+inline std::uint64_t hash_device_id(DeviceId id)
+{
+    id ^= id >> 30;
+    id *= 0xbf58476d1ce4e5b9ULL;
+    id ^= id >> 27;
+    id *= 0x94d049bb133111ebULL;
+    id ^= id >> 31;
+    return id;
+}
+} // namespace tsvetkov
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <random>
+
+namespace tsvetkov {
+// Retry delays growing as initial * 2^attempt up to `max`, with "full jitter": each delay is drawn uniformly from
+// [0, cap], so clients that failed at the same moment spread their retries over the whole window instead of
+// retrying in lockstep.
+class ExponentialBackoff
+{
+public:
+    using duration_type = std::chrono::steady_clock::duration;
+
+    ExponentialBackoff(duration_type initial, duration_type max, std::uint64_t seed)
+        : initial_(initial), max_(std::max(initial, max)), random_(seed)
+    {
+    }
+
+    duration_type next()
+    {
+        auto cap = initial_;
+        for (std::uint32_t i = 0; i < attempt_ && cap < max_; ++i) {
+            cap *= 2;
+        }
+        cap = std::min(cap, max_);
+        ++attempt_;
+        std::uniform_int_distribution<duration_type::rep> distribution(0, cap.count());
+        return duration_type(distribution(random_));
+    }
+
+    void reset()
+    {
+        attempt_ = 0;
+    }
+
+    std::uint32_t attempt() const
+    {
+        return attempt_;
+    }
+
+private:
+    duration_type initial_;
+    duration_type max_;
+    std::uint32_t attempt_ = 0;
+    std::minstd_rand random_;
+};
+} // namespace tsvetkov
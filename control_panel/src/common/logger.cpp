@@ -0,0 +1,231 @@
+#include "logger.hpp"
+
+#include <ctime>
+
+namespace tsvetkov {
+namespace {
+constexpr std::array<std::string_view, 6> level_names = {"trace", "debug", "info", "warning", "error", "none"};
+
+void write_to_stdout(std::string_view lines)
+{
+    std::fwrite(lines.data(), 1, lines.size(), stdout);
+    std::fflush(stdout);
+}
+} // namespace
+
+std::string_view to_string(LogLevel level)
+{
+    return level_names[static_cast<std::size_t>(level)];
+}
+
+std::optional<LogLevel> parse_log_level(std::string_view name)
+{
+    for (std::size_t i = 0; i < level_names.size(); ++i) {
+        if (level_names[i] == name) {
+            return static_cast<LogLevel>(i);
+        }
+    }
+    return std::nullopt;
+}
+
+// Single-producer single-consumer ring of one logging thread.
+struct Logger::Ring
+{
+    static constexpr std::size_t capacity = 512;
+
+    std::array<LogRecord, capacity> records;
+    alignas(64) std::atomic<std::uint64_t> head{0};
+    alignas(64) std::atomic<std::uint64_t> tail{0};
+    std::atomic<std::uint64_t> dropped{0};
+    // Set when the owning thread exits: the writer frees the ring once it is empty.
+    std::atomic<bool> is_closed{false};
+};
+
+Logger& Logger::instance()
+{
+    static Logger logger;
+    return logger;
+}
+
+Logger::Logger() : sink_(write_to_stdout)
+{
+    writer_ = std::thread([this] { run(); });
+}
+
+Logger::~Logger()
+{
+    {
+        std::lock_guard lock_guard(pass_mutex_);
+        is_stopping_ = true;
+    }
+    pass_condition_.notify_all();
+    writer_.join();
+}
+
+void Logger::set_level(LogLevel level)
+{
+    level_.store(level, std::memory_order_relaxed);
+}
+
+Logger::sink_type Logger::set_sink(sink_type sink)
+{
+    if (!sink) {
+        sink = write_to_stdout;
+    }
+    std::lock_guard lock_guard(sink_mutex_);
+    std::swap(sink_, sink);
+    return sink;
+}
+
+Logger::Ring& Logger::local_ring()
+{
+    // Closes the ring when the thread exits.
+    struct LocalRing
+    {
+        ~LocalRing()
+        {
+            if (ring) {
+                ring->is_closed.store(true, std::memory_order_release);
+            }
+        }
+
+        std::shared_ptr<Ring> ring;
+    };
+    thread_local LocalRing local;
+
+    if (!local.ring) {
+        local.ring = std::make_shared<Ring>();
+        std::lock_guard lock_guard(rings_mutex_);
+        rings_.push_back(local.ring);
+    }
+    return *local.ring;
+}
+
+void Logger::push(const LogRecord& record)
+{
+    auto& ring = local_ring();
+    auto head  = ring.head.load(std::memory_order_relaxed);
+    if (head - ring.tail.load(std::memory_order_acquire) == Ring::capacity) {
+        ring.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    ring.records[head % Ring::capacity] = record;
+    ring.head.store(head + 1, std::memory_order_release);
+}
+
+void Logger::flush()
+{
+    std::unique_lock lock(pass_mutex_);
+    auto target        = passes_started_ + 1;
+    is_wake_requested_ = true;
+    pass_condition_.notify_all();
+    pass_condition_.wait(lock, [&] { return passes_finished_ >= target || is_stopping_; });
+}
+
+Logger::Stats Logger::stats() const
+{
+    Stats result;
+    result.written = written_.load(std::memory_order_relaxed);
+    std::lock_guard lock_guard(rings_mutex_);
+    result.dropped = retired_dropped_;
+    for (const auto& ring : rings_) {
+        result.dropped += ring->dropped.load(std::memory_order_relaxed);
+    }
+    return result;
+}
+
+void Logger::run()
+{
+    while (true) {
+        std::uint64_t pass;
+        bool is_last_pass;
+        {
+            std::unique_lock lock(pass_mutex_);
+            // Producers never signal: poll often enough that a ring rarely fills up.
+            pass_condition_.wait_for(lock, std::chrono::milliseconds(2), [&] {
+                return is_wake_requested_ || is_stopping_;
+            });
+            is_wake_requested_ = false;
+            is_last_pass       = is_stopping_;
+            pass               = ++passes_started_;
+        }
+        drain();
+        {
+            std::lock_guard lock_guard(pass_mutex_);
+            passes_finished_ = pass;
+        }
+        pass_condition_.notify_all();
+        if (is_last_pass) {
+            return;
+        }
+    }
+}
+
+std::size_t Logger::drain()
+{
+    {
+        std::lock_guard lock_guard(rings_mutex_);
+        // Rings of exited threads, once empty, are not needed any more.
+        auto is_retired = [this](const std::shared_ptr<Ring>& ring) {
+            if (!ring->is_closed.load(std::memory_order_acquire) ||
+                ring->tail.load(std::memory_order_relaxed) != ring->head.load(std::memory_order_acquire)) {
+                return false;
+            }
+            retired_dropped_ += ring->dropped.load(std::memory_order_relaxed);
+            return true;
+        };
+        rings_.erase(std::remove_if(rings_.begin(), rings_.end(), is_retired), rings_.end());
+        draining_.assign(rings_.begin(), rings_.end());
+    }
+
+    std::size_t count = 0;
+    lines_.clear();
+    for (const auto& ring : draining_) {
+        auto tail = ring->tail.load(std::memory_order_relaxed);
+        auto head = ring->head.load(std::memory_order_acquire);
+        for (auto i = tail; i != head; ++i) {
+            format(ring->records[i % Ring::capacity]);
+        }
+        ring->tail.store(head, std::memory_order_release);
+        count += head - tail;
+    }
+    draining_.clear();
+
+    if (!lines_.empty()) {
+        std::lock_guard lock_guard(sink_mutex_);
+        sink_(lines_);
+    }
+    written_.fetch_add(count, std::memory_order_relaxed);
+    return count;
+}
+
+// 2026-10-17T09:41:07.123456Z info client: text
+void Logger::format(const LogRecord& record)
+{
+    using namespace std::chrono;
+    auto since_epoch  = duration_cast<microseconds>(record.timestamp.time_since_epoch());
+    auto seconds      = static_cast<std::time_t>(since_epoch.count() / 1000000);
+    auto microseconds = static_cast<long>(since_epoch.count() % 1000000);
+    std::tm tm{};
+    gmtime_r(&seconds, &tm);
+
+    std::array<char, 40> timestamp;
+    auto size = std::snprintf(timestamp.data(),
+                              timestamp.size(),
+                              "%04d-%02d-%02dT%02d:%02d:%02d.%06ldZ ",
+                              tm.tm_year + 1900,
+                              tm.tm_mon + 1,
+                              tm.tm_mday,
+                              tm.tm_hour,
+                              tm.tm_min,
+                              tm.tm_sec,
+                              microseconds);
+    lines_.append(timestamp.data(), static_cast<std::size_t>(size));
+    lines_.append(to_string(record.level));
+    lines_.push_back(' ');
+    lines_.append(record.component);
+    lines_.append(": ");
+    lines_.append(record.text.data(), record.size);
+    lines_.push_back('\n');
+}
+} // namespace tsvetkov
@@ -0,0 +1,251 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Lowest level compiled in: 0 trace, 1 debug, 2 info, 3 warning, 4 error, 5 none. Calls below it compile to nothing.
+#ifndef TSVETKOV_LOG_LEVEL
+#define TSVETKOV_LOG_LEVEL 1
+#endif
+
+namespace tsvetkov {
+enum class LogLevel : std::uint8_t
+{
+    Trace,
+    Debug,
+    Info,
+    Warning,
+    Error,
+    None
+};
+
+constexpr LogLevel compiled_log_level = static_cast<LogLevel>(TSVETKOV_LOG_LEVEL);
+
+std::string_view to_string(LogLevel level);
+std::optional<LogLevel> parse_log_level(std::string_view name);
+
+// One line on its way from a logging thread to the writer. Fixed size, so logging never allocates; longer text is
+// cut off.
+struct LogRecord
+{
+    static constexpr std::size_t max_text = 224;
+
+    void append(std::string_view text)
+    {
+        auto count = std::min(text.size(), max_text - size);
+        std::memcpy(this->text.data() + size, text.data(), count);
+        size = static_cast<std::uint16_t>(size + count);
+    }
+
+    std::chrono::system_clock::time_point timestamp;
+    const char* component = "";
+    LogLevel level        = LogLevel::Info;
+    std::uint16_t size    = 0;
+    std::array<char, max_text> text;
+};
+
+namespace detail {
+inline void append(LogRecord& record, std::string_view value)
+{
+    record.append(value);
+}
+
+inline void append(LogRecord& record, const char* value)
+{
+    record.append(value);
+}
+
+inline void append(LogRecord& record, char value)
+{
+    record.append(std::string_view(&value, 1));
+}
+
+inline void append(LogRecord& record, bool value)
+{
+    record.append(value ? "true" : "false");
+}
+
+template<typename T>
+std::enable_if_t<std::is_integral_v<T>> append(LogRecord& record, T value)
+{
+    std::array<char, 24> buffer;
+    auto result = std::to_chars(buffer.data(), buffer.data() + buffer.size(), value);
+    record.append(std::string_view(buffer.data(), static_cast<std::size_t>(result.ptr - buffer.data())));
+}
+
+template<typename T>
+std::enable_if_t<std::is_enum_v<T>> append(LogRecord& record, T value)
+{
+    append(record, static_cast<std::underlying_type_t<T>>(value));
+}
+
+inline void append(LogRecord& record, double value)
+{
+    std::array<char, 32> buffer;
+    auto size = std::snprintf(buffer.data(), buffer.size(), "%g", value);
+    record.append(std::string_view(buffer.data(), static_cast<std::size_t>(std::max(size, 0))));
+}
+
+// "category:value", like operator<<. Not message(), which builds a std::string.
+inline void append(LogRecord& record, const std::error_code& value)
+{
+    record.append(value.category().name());
+    append(record, ':');
+    append(record, value.value());
+}
+} // namespace detail
+
+// Process-wide asynchronous logger. A logging thread formats its arguments into a LogRecord and copies it into a ring
+// of its own: no lock, no syscall, no allocation. A background thread drains the rings, formats the lines and hands
+// them to the sink in batches. A thread whose ring is full drops the record rather than wait; stats() counts the
+// drops. Lines of one thread keep their order, lines of different threads may interleave out of time order.
+class Logger
+{
+public:
+    // Receives one or more complete lines, newlines included. Called on the writer thread only.
+    using sink_type = std::function<void(std::string_view lines)>;
+
+    struct Stats
+    {
+        std::uint64_t written = 0;
+        std::uint64_t dropped = 0;
+    };
+
+    static Logger& instance();
+
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+
+    ~Logger();
+
+    bool is_enabled(LogLevel level) const
+    {
+        return level >= level_.load(std::memory_order_relaxed);
+    }
+
+    // Runtime threshold on top of compiled_log_level; Info by default.
+    void set_level(LogLevel level);
+    LogLevel level() const
+    {
+        return level_.load(std::memory_order_relaxed);
+    }
+    // Defaults to stdout, as does an empty sink. Returns the sink it replaces.
+    sink_type set_sink(sink_type sink);
+
+    void push(const LogRecord& record);
+    // Returns once all lines the calling thread logged before the call have reached the sink.
+    void flush();
+
+    Stats stats() const;
+
+private:
+    struct Ring;
+
+    Logger();
+
+    Ring& local_ring();
+    void run();
+    std::size_t drain();
+    void format(const LogRecord& record);
+
+    std::atomic<LogLevel> level_{LogLevel::Info};
+
+    mutable std::mutex rings_mutex_;
+    std::vector<std::shared_ptr<Ring>> rings_;
+    std::uint64_t retired_dropped_ = 0;
+
+    // Writer thread only.
+    std::vector<std::shared_ptr<Ring>> draining_;
+    std::string lines_;
+
+    std::mutex sink_mutex_;
+    sink_type sink_;
+
+    // flush() waits for a pass of the writer that started after it was called.
+    std::mutex pass_mutex_;
+    std::condition_variable pass_condition_;
+    std::uint64_t passes_started_  = 0;
+    std::uint64_t passes_finished_ = 0;
+    bool is_wake_requested_        = false;
+    bool is_stopping_              = false;
+
+    std::atomic<std::uint64_t> written_{0};
+    std::thread writer_;
+};
+
+template<LogLevel level>
+bool log_enabled()
+{
+    if constexpr (level >= compiled_log_level && level != LogLevel::None) {
+        return Logger::instance().is_enabled(level);
+    } else {
+        return false;
+    }
+}
+
+// log<LogLevel::Info>("client", "connected in ", ms, " ms"): the arguments are concatenated. Strings, characters,
+// numbers, enums (as numbers) and std::error_code are accepted.
+template<LogLevel level, typename... Args>
+void log(const char* component, const Args&... args)
+{
+    if constexpr (level >= compiled_log_level && level != LogLevel::None) {
+        auto& logger = Logger::instance();
+        if (!logger.is_enabled(level)) {
+            return;
+        }
+        LogRecord record;
+        record.timestamp = std::chrono::system_clock::now();
+        record.component = component;
+        record.level     = level;
+        (detail::append(record, args), ...);
+        logger.push(record);
+    }
+}
+
+template<typename... Args>
+void log_trace(const char* component, const Args&... args)
+{
+    log<LogLevel::Trace>(component, args...);
+}
+
+template<typename... Args>
+void log_debug(const char* component, const Args&... args)
+{
+    log<LogLevel::Debug>(component, args...);
+}
+
+template<typename... Args>
+void log_info(const char* component, const Args&... args)
+{
+    log<LogLevel::Info>(component, args...);
+}
+
+template<typename... Args>
+void log_warning(const char* component, const Args&... args)
+{
+    log<LogLevel::Warning>(component, args...);
+}
+
+template<typename... Args>
+void log_error(const char* component, const Args&... args)
+{
+    log<LogLevel::Error>(component, args...);
+}
+} // namespace tsvetkov
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+
+namespace tsvetkov {
+struct MpscQueueNode
+{
+    std::atomic<MpscQueueNode*> next{nullptr};
+};
+
+// Intrusive multi-producer single-consumer queue (D. Vyukov). push() is wait-free: one exchange and one store, no
+// allocation and no lock. pop() belongs to a single consumer and may return nullptr while a push is half done; the
+// producer of that push is not finished yet, so a "push, then wake the consumer" protocol never loses an element.
+// The queue does not own its elements: T derives from MpscQueueNode and the consumer disposes of what it pops.
+template<typename T>
+class MpscQueue
+{
+public:
+    MpscQueue() : head_(&stub_), tail_(&stub_) {}
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    void push(T* element)
+    {
+        push_node(element);
+    }
+
+    T* pop()
+    {
+        auto tail = tail_;
+        auto next = tail->next.load(std::memory_order_acquire);
+        if (tail == &stub_) {
+            if (!next) {
+                return nullptr;
+            }
+            tail_ = next;
+            tail  = next;
+            next  = next->next.load(std::memory_order_acquire);
+        }
+        if (next) {
+            tail_ = next;
+            return static_cast<T*>(tail);
+        }
+        if (tail != head_.load(std::memory_order_acquire)) {
+            // a producer swapped the head but has not linked its node yet
+            return nullptr;
+        }
+        push_node(&stub_);
+        next = tail->next.load(std::memory_order_acquire);
+        if (next) {
+            tail_ = next;
+            return static_cast<T*>(tail);
+        }
+        return nullptr;
+    }
+
+private:
+    void push_node(MpscQueueNode* node)
+    {
+        node->next.store(nullptr, std::memory_order_relaxed);
+        auto prev = head_.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    std::atomic<MpscQueueNode*> head_;
+    MpscQueueNode* tail_;
+    MpscQueueNode stub_;
+};
+} // namespace tsvetkov
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace tsvetkov {
+// Pending requests keyed by their 32-bit request id, stored in a preallocated power-of-two table. The slot is
+// `id & mask`; the remaining high bits of the stored id act as a generation tag, so a late response carrying an
+// id from before the counter wrapped around finds a different id in the slot and is ignored.
+template<typename T>
+class RequestTable
+{
+public:
+    explicit RequestTable(std::size_t capacity) : slots_(round_up(capacity)), mask_(slots_.size() - 1) {}
+
+    std::size_t capacity() const
+    {
+        return slots_.size();
+    }
+
+    std::size_t size() const
+    {
+        return size_;
+    }
+
+    // Index of the slot that `id` occupies, for state kept alongside the table.
+    std::size_t slot(std::uint32_t id) const
+    {
+        return id & mask_;
+    }
+
+    bool is_free(std::uint32_t id) const
+    {
+        return !slots_[id & mask_].value;
+    }
+
+    // Returns false if the slot of `id` is still taken by an older request.
+    bool insert(std::uint32_t id, T value)
+    {
+        auto& slot = slots_[id & mask_];
+        if (slot.value) {
+            return false;
+        }
+        slot.id = id;
+        slot.value.emplace(std::move(value));
+        ++size_;
+        return true;
+    }
+
+    std::optional<T> take(std::uint32_t id)
+    {
+        auto& slot = slots_[id & mask_];
+        if (!slot.value || slot.id != id) {
+            return std::nullopt;
+        }
+        std::optional<T> result(std::move(slot.value));
+        slot.value.reset();
+        --size_;
+        return result;
+    }
+
+    template<typename F>
+    void take_all(F&& f)
+    {
+        for (auto& slot : slots_) {
+            if (slot.value) {
+                auto value = std::move(*slot.value);
+                slot.value.reset();
+                --size_;
+                f(slot.id, std::move(value));
+            }
+        }
+    }
+
+private:
+    struct Slot
+    {
+        std::uint32_t id = 0;
+        std::optional<T> value;
+    };
+
+    static std::size_t round_up(std::size_t n)
+    {
+        std::size_t result = 1;
+        while (result < n) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    std::vector<Slot> slots_;
+    std::uint32_t mask_;
+    std::size_t size_ = 0;
+};
+} // namespace tsvetkov
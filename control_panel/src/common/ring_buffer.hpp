@@ -0,0 +1,87 @@
+#pragma once
+
+#include <asio/buffer.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+
+namespace tsvetkov {
+// Fixed-capacity byte ring for stream sockets. The socket reads straight into the free space (prepare/commit),
+// the parser takes contiguous views of complete frames (peek/consume). Only a frame that wraps around the end of
+// the storage is copied, into a scratch buffer; everything else is handed out in place.
+template<std::size_t Capacity>
+class RingBuffer
+{
+    static_assert(Capacity != 0 && (Capacity & (Capacity - 1)) == 0, "RingBuffer capacity must be a power of two");
+
+public:
+    static constexpr std::size_t capacity = Capacity;
+
+    std::size_t size() const
+    {
+        return tail_ - head_;
+    }
+
+    bool empty() const
+    {
+        return head_ == tail_;
+    }
+
+    std::size_t free_space() const
+    {
+        return Capacity - size();
+    }
+
+    // Free space as at most two regions: [tail, end) and [0, head).
+    std::array<asio::mutable_buffer, 2> prepare()
+    {
+        auto begin = tail_ & mask;
+        auto free  = free_space();
+        auto first = std::min(free, Capacity - begin);
+        return {asio::buffer(&data_[begin], first), asio::buffer(&data_[0], free - first)};
+    }
+
+    void commit(std::size_t n)
+    {
+        tail_ += std::min(n, free_space());
+    }
+
+    // Pointer to the first `n` readable bytes, n <= size().
+    const char* peek(std::size_t n)
+    {
+        auto begin = head_ & mask;
+        if (begin + n <= Capacity) {
+            return &data_[begin];
+        }
+        auto first = Capacity - begin;
+        std::memcpy(&scratch_[0], &data_[begin], first);
+        std::memcpy(&scratch_[first], &data_[0], n - first);
+        return &scratch_[0];
+    }
+
+    void consume(std::size_t n)
+    {
+        head_ += std::min(n, size());
+        if (head_ == tail_) {
+            // Start over from the beginning so that the next read gets the largest contiguous region.
+            clear();
+        }
+    }
+
+    void clear()
+    {
+        head_ = 0;
+        tail_ = 0;
+    }
+
+private:
+    static constexpr std::size_t mask = Capacity - 1;
+
+    std::size_t head_ = 0;
+    std::size_t tail_ = 0;
+    std::array<char, Capacity> data_;
+    std::array<char, Capacity> scratch_;
+};
+} // namespace tsvetkov
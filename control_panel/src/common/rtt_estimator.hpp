@@ -0,0 +1,80 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+namespace tsvetkov {
+// Smoothed round-trip time, its variation and the retransmission timeout derived from them, as TCP computes them
+// (RFC 6298): SRTT and RTTVAR are EWMAs with gains 1/8 and 1/4, RTO = SRTT + max(G, 4 * RTTVAR) clamped to
+// [min_rto, max_rto]. Until the first sample RTO is `initial_rto`.
+class RttEstimator
+{
+public:
+    using duration_type = std::chrono::steady_clock::duration;
+
+    RttEstimator(duration_type initial_rto, duration_type min_rto, duration_type max_rto, duration_type granularity)
+        : min_rto_(min_rto), max_rto_(std::max(min_rto, max_rto)), granularity_(granularity), rto_(clamp(initial_rto))
+    {
+    }
+
+    void add_sample(duration_type rtt)
+    {
+        rtt = std::max(rtt, duration_type::zero());
+        if (samples_ == 0) {
+            srtt_   = rtt;
+            rttvar_ = rtt / 2;
+        } else {
+            auto error = srtt_ > rtt ? srtt_ - rtt : rtt - srtt_;
+            rttvar_    = (3 * rttvar_ + error) / 4;
+            srtt_      = (7 * srtt_ + rtt) / 8;
+        }
+        ++samples_;
+        rto_ = clamp(srtt_ + std::max(granularity_, 4 * rttvar_));
+    }
+
+    // Timeout for the `attempt`-th consecutive unanswered probe, doubled per attempt (RFC 6298, 5.5).
+    duration_type backoff(std::uint32_t attempt) const
+    {
+        auto result = rto_;
+        for (std::uint32_t i = 0; i < attempt && result < max_rto_; ++i) {
+            result *= 2;
+        }
+        return std::min(result, max_rto_);
+    }
+
+    duration_type srtt() const
+    {
+        return srtt_;
+    }
+
+    duration_type rttvar() const
+    {
+        return rttvar_;
+    }
+
+    duration_type rto() const
+    {
+        return rto_;
+    }
+
+    std::uint64_t samples() const
+    {
+        return samples_;
+    }
+
+private:
+    duration_type clamp(duration_type value) const
+    {
+        return std::min(std::max(value, min_rto_), max_rto_);
+    }
+
+    duration_type min_rto_;
+    duration_type max_rto_;
+    duration_type granularity_;
+    duration_type srtt_{};
+    duration_type rttvar_{};
+    duration_type rto_;
+    std::uint64_t samples_ = 0;
+};
+} // namespace tsvetkov
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+namespace tsvetkov {
+// Value published by one writer and read by any number of threads without locks. The writer never waits; a read
+// copies the value and retries only if a write overlapped the copy, so readers never block the writer nor each
+// other. Writers must be serialized externally (e.g. by running on one strand). T must be trivially copyable; it is
+// kept in relaxed atomic words, so concurrent reads and writes are race-free.
+template<typename T>
+class SeqLock
+{
+    static_assert(std::is_trivially_copyable_v<T>, "SeqLock values are copied word by word");
+
+public:
+    SeqLock() : SeqLock(T{}) {}
+
+    explicit SeqLock(const T& value)
+    {
+        store_words(value);
+    }
+
+    SeqLock(const SeqLock&) = delete;
+    SeqLock& operator=(const SeqLock&) = delete;
+
+    void store(const T& value)
+    {
+        auto sequence = sequence_.load(std::memory_order_relaxed);
+        sequence_.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        store_words(value);
+        sequence_.store(sequence + 2, std::memory_order_release);
+    }
+
+    T load() const
+    {
+        std::array<std::uint64_t, word_count> buffer;
+        while (true) {
+            auto before = sequence_.load(std::memory_order_acquire);
+            if (before & 1u) {
+                std::this_thread::yield();
+                continue;
+            }
+            for (std::size_t i = 0; i < word_count; ++i) {
+                buffer[i] = words_[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence_.load(std::memory_order_relaxed) == before) {
+                break;
+            }
+        }
+        T value;
+        std::memcpy(static_cast<void*>(&value), buffer.data(), sizeof(T));
+        return value;
+    }
+
+    // Number of stores so far.
+    std::uint64_t version() const
+    {
+        return sequence_.load(std::memory_order_acquire) / 2;
+    }
+
+private:
+    static constexpr std::size_t word_count = (sizeof(T) + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t);
+
+    void store_words(const T& value)
+    {
+        std::array<std::uint64_t, word_count> buffer{};
+        std::memcpy(buffer.data(), &value, sizeof(T));
+        for (std::size_t i = 0; i < word_count; ++i) {
+            words_[i].store(buffer[i], std::memory_order_relaxed);
+        }
+    }
+
+    std::atomic<std::uint64_t> sequence_{0};
+    std::array<std::atomic<std::uint64_t>, word_count> words_{};
+};
+} // namespace tsvetkov
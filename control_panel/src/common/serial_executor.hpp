@@ -0,0 +1,67 @@
+#pragma once
+
+#include <asio/io_context.hpp>
+#include <asio/io_context_strand.hpp>
+#include <asio/post.hpp>
+
+#include <portable_concurrency/execution>
+
+#include <optional>
+
+namespace tsvetkov {
+// Executor that runs the handlers of one object one at a time. On an io_context driven by several threads it
+// serializes through a strand. On an io_context owned by a single thread (a shard of ShardedRuntime) the handlers
+// are already serialized, so they are posted to the io_context directly and skip the strand's lock.
+class SerialExecutor
+{
+public:
+    static SerialExecutor strand(asio::io_context& io)
+    {
+        return SerialExecutor(io, true);
+    }
+
+    static SerialExecutor single_threaded(asio::io_context& io)
+    {
+        return SerialExecutor(io, false);
+    }
+
+    asio::io_context& context() const
+    {
+        return *io_context_;
+    }
+
+    template<typename F>
+    void post(F&& f) const
+    {
+        if (strand_) {
+            asio::post(*strand_, std::forward<F>(f));
+        } else {
+            asio::post(*io_context_, std::forward<F>(f));
+        }
+    }
+
+private:
+    SerialExecutor(asio::io_context& io, bool use_strand) : io_context_(&io)
+    {
+        if (use_strand) {
+            strand_.emplace(io);
+        }
+    }
+
+    asio::io_context* io_context_;
+    std::optional<asio::io_context::strand> strand_;
+};
+
+template<typename F>
+void post(const SerialExecutor& executor, F&& f)
+{
+    executor.post(std::forward<F>(f));
+}
+} // namespace tsvetkov
+
+namespace portable_concurrency {
+template<>
+struct is_executor<tsvetkov::SerialExecutor> : std::true_type
+{
+};
+} // namespace portable_concurrency
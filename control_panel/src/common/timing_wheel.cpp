@@ -0,0 +1,193 @@
+#include "timing_wheel.hpp"
+
+#include <algorithm>
+
+namespace tsvetkov {
+asio::execution_context::id TimingWheel::id;
+
+constexpr TimingWheel::duration_type TimingWheel::resolution;
+
+TimerNode::~TimerNode()
+{
+    if (!owner_) {
+        return;
+    }
+    // Blocks while the wheel runs callbacks, this node's included.
+    std::lock_guard lock_guard(owner_->mutex);
+    if (owner_->wheel) {
+        owner_->wheel->cancel(*this);
+    }
+}
+
+TimingWheel::TimingWheel(asio::io_context& io)
+    : asio::execution_context::service(io),
+      state_(std::make_shared<detail::TimingWheelState>()),
+      mutex_(state_->mutex),
+      timer_(io),
+      start_(clock_type::now())
+{
+    state_->wheel = this;
+}
+
+TimingWheel::~TimingWheel()
+{
+    shutdown();
+    std::lock_guard lock_guard(mutex_);
+    state_->wheel = nullptr;
+}
+
+void TimingWheel::schedule(TimerNode& node, duration_type delay)
+{
+    std::lock_guard lock_guard(mutex_);
+    if (node.pprev_) {
+        unlink(node);
+    }
+    if (!node.owner_) {
+        node.owner_ = state_;
+    }
+    auto elapsed = clock_type::now() - start_;
+    if (size_ == 0) {
+        // nothing is linked, the wheel may simply jump to the present
+        now_tick_ = std::max(now_tick_, static_cast<std::uint64_t>(elapsed / resolution));
+    }
+    // The first tick that starts no earlier than now + delay: rounding the present down would fire up to a tick early.
+    auto due     = elapsed + std::max(delay, duration_type::zero());
+    auto expiry  = static_cast<std::uint64_t>((due + resolution - duration_type(1)) / resolution);
+    node.expiry_ = std::max(expiry, now_tick_ + 1);
+    insert(node);
+    arm();
+}
+
+void TimingWheel::cancel(TimerNode& node)
+{
+    std::lock_guard lock_guard(mutex_);
+    if (node.pprev_) {
+        unlink(node);
+    }
+}
+
+bool TimingWheel::is_scheduled(const TimerNode& node) const
+{
+    std::lock_guard lock_guard(mutex_);
+    return node.pprev_ != nullptr;
+}
+
+std::size_t TimingWheel::size() const
+{
+    std::lock_guard lock_guard(mutex_);
+    return size_;
+}
+
+void TimingWheel::shutdown()
+{
+    std::lock_guard lock_guard(mutex_);
+    for (auto& level : wheel_) {
+        for (auto& head : level) {
+            while (head) {
+                unlink(*head);
+            }
+        }
+    }
+    timer_.cancel();
+    is_armed_ = false;
+}
+
+std::uint64_t TimingWheel::current_tick() const
+{
+    return static_cast<std::uint64_t>((clock_type::now() - start_) / resolution);
+}
+
+void TimingWheel::insert(TimerNode& node)
+{
+    const auto max_delta = (std::uint64_t{1} << (level_bits * levels)) - 1;
+    if (node.expiry_ < now_tick_) {
+        // only cascade() reinserts at the current tick, and it runs before the current slot fires
+        node.expiry_ = now_tick_;
+    } else if (node.expiry_ - now_tick_ > max_delta) {
+        node.expiry_ = now_tick_ + max_delta;
+    }
+    auto delta = node.expiry_ - now_tick_;
+
+    std::size_t level = 0;
+    while (level + 1 < levels && delta >= (std::uint64_t{1} << (level_bits * (level + 1)))) {
+        ++level;
+    }
+    auto& head = wheel_[level][(node.expiry_ >> (level_bits * level)) & (slots - 1)];
+
+    node.next_  = head;
+    node.pprev_ = &head;
+    if (head) {
+        head->pprev_ = &node.next_;
+    }
+    head = &node;
+    ++size_;
+}
+
+void TimingWheel::unlink(TimerNode& node)
+{
+    *node.pprev_ = node.next_;
+    if (node.next_) {
+        node.next_->pprev_ = node.pprev_;
+    }
+    node.next_  = nullptr;
+    node.pprev_ = nullptr;
+    --size_;
+}
+
+void TimingWheel::cascade(std::size_t level)
+{
+    auto& head = wheel_[level][(now_tick_ >> (level_bits * level)) & (slots - 1)];
+    while (head) {
+        auto& node = *head;
+        unlink(node);
+        insert(node);
+    }
+}
+
+void TimingWheel::advance()
+{
+    ++now_tick_;
+    for (std::size_t level = 1; level < levels; ++level) {
+        if ((now_tick_ & ((std::uint64_t{1} << (level_bits * level)) - 1)) != 0) {
+            break;
+        }
+        cascade(level);
+    }
+    auto& head = wheel_[0][now_tick_ & (slots - 1)];
+    while (head) {
+        auto& node = *head;
+        unlink(node);
+        // Still under the lock: cancelling or destroying the node on another thread waits until the callback returns.
+        if (node.callback_) {
+            node.callback_();
+        }
+    }
+}
+
+void TimingWheel::arm()
+{
+    if (is_armed_ || size_ == 0) {
+        return;
+    }
+    is_armed_ = true;
+    timer_.expires_at(start_ + resolution * static_cast<clock_type::rep>(now_tick_ + 1));
+    timer_.async_wait([this](const std::error_code& ec) { on_timer(ec); });
+}
+
+void TimingWheel::on_timer(const std::error_code& ec)
+{
+    std::lock_guard lock_guard(mutex_);
+    is_armed_ = false;
+    if (ec == asio::error::operation_aborted) {
+        return;
+    }
+    auto now = current_tick();
+    while (now_tick_ < now && size_ != 0) {
+        advance();
+    }
+    if (size_ == 0) {
+        now_tick_ = std::max(now_tick_, now);
+    }
+    arm();
+}
+} // namespace tsvetkov
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "asio.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+namespace tsvetkov {
+class TimingWheel;
+
+namespace detail {
+// Outlives the wheel as long as a node that was ever scheduled on it, so that destroying the node can always lock it.
+struct TimingWheelState
+{
+    std::recursive_mutex mutex;
+    // Reset when the wheel goes away.
+    TimingWheel* wheel = nullptr;
+};
+} // namespace detail
+
+// Intrusive timer handle. The callback is set once; scheduling and cancelling only relink the node, so re-arming a
+// timer never allocates. Destroying a node cancels it, and waits for its callback if that is running on another
+// thread: the wheel holds its lock while callbacks run.
+class TimerNode
+{
+public:
+    TimerNode() = default;
+    explicit TimerNode(std::function<void()> callback) : callback_(std::move(callback)) {}
+    ~TimerNode();
+
+    TimerNode(const TimerNode&) = delete;
+    TimerNode& operator=(const TimerNode&) = delete;
+
+    void set_callback(std::function<void()> callback)
+    {
+        callback_ = std::move(callback);
+    }
+
+    bool has_callback() const
+    {
+        return static_cast<bool>(callback_);
+    }
+
+private:
+    friend class TimingWheel;
+
+    // `pprev_` points at whatever points at this node: the slot head or the previous node's `next_`. Null while the
+    // node is not scheduled. All three are guarded by the lock of `owner_`.
+    TimerNode* next_      = nullptr;
+    TimerNode** pprev_    = nullptr;
+    std::uint64_t expiry_ = 0;
+    // Set by the first schedule() and kept, so the destructor never races with the wheel unlinking the node.
+    std::shared_ptr<detail::TimingWheelState> owner_;
+    std::function<void()> callback_;
+};
+
+// Hierarchical timing wheel shared by everything that runs on one io_context (heartbeats, reconnect delays, discovery
+// re-sends, request deadlines), obtained with asio::use_service<TimingWheel>(io). One steady_timer drives it, and
+// only while something is scheduled. schedule() and cancel() are O(1). The wheel has 4 levels of 64 slots at
+// `resolution` granularity, so delays up to 64^4 ticks are kept exactly and longer ones are clamped.
+//
+// Callbacks run on the io_context with the wheel locked: they must be short and should only post work to their
+// owner's executor. They may schedule or cancel timers.
+class TimingWheel : public asio::execution_context::service
+{
+public:
+    using clock_type    = std::chrono::steady_clock;
+    using duration_type = clock_type::duration;
+
+    static asio::execution_context::id id;
+
+    static constexpr duration_type resolution = std::chrono::milliseconds(10);
+
+    explicit TimingWheel(asio::io_context& io);
+    ~TimingWheel() override;
+
+    // (Re)arms `node` to fire once after `delay`.
+    void schedule(TimerNode& node, duration_type delay);
+    void cancel(TimerNode& node);
+    bool is_scheduled(const TimerNode& node) const;
+
+    std::size_t size() const;
+
+private:
+    static constexpr std::size_t level_bits = 6;
+    static constexpr std::size_t slots      = std::size_t{1} << level_bits;
+    static constexpr std::size_t levels     = 4;
+
+    void shutdown() override;
+
+    std::uint64_t current_tick() const;
+    void insert(TimerNode& node);
+    void unlink(TimerNode& node);
+    void cascade(std::size_t level);
+    void advance();
+    void arm();
+    void on_timer(const std::error_code& ec);
+
+    std::shared_ptr<detail::TimingWheelState> state_;
+    std::recursive_mutex& mutex_;
+    asio::steady_timer timer_;
+    clock_type::time_point start_;
+    std::uint64_t now_tick_ = 0;
+    std::size_t size_       = 0;
+    bool is_armed_          = false;
+    std::array<std::array<TimerNode*, slots>, levels> wheel_{};
+};
+} // namespace tsvetkov
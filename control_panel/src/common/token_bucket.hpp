@@ -0,0 +1,64 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+
+namespace tsvetkov {
+// Rate limit: tokens accrue at `rate` per second, up to `burst` saved (at least one); a rate of zero or less means
+// unlimited. Time is passed in by the caller, so the bucket is a plain value with no clock, timer or lock of its own.
+class TokenBucket
+{
+public:
+    using clock_type    = std::chrono::steady_clock;
+    using duration_type = clock_type::duration;
+
+    TokenBucket(double rate, double burst, clock_type::time_point now)
+        : rate_(rate), burst_(std::max(burst, 1.0)), tokens_(burst_), last_refill_(now)
+    {
+    }
+
+    // Takes up to `wanted` whole tokens and returns how many were taken.
+    std::size_t take(std::size_t wanted, clock_type::time_point now)
+    {
+        refill(now);
+        auto taken = std::min(wanted, static_cast<std::size_t>(tokens_));
+        tokens_ -= static_cast<double>(taken);
+        return taken;
+    }
+
+    // Delay until `count` tokens (at most burst) are available, zero if they already are.
+    duration_type time_until(std::size_t count, clock_type::time_point now)
+    {
+        refill(now);
+        auto missing = std::min(static_cast<double>(count), burst_) - tokens_;
+        if (missing <= 0.0) {
+            return duration_type::zero();
+        }
+        return std::chrono::ceil<duration_type>(std::chrono::duration<double>(missing / rate_));
+    }
+
+    // Gives back tokens taken but not used, up to burst.
+    void refund(std::size_t count)
+    {
+        tokens_ = std::min(burst_, tokens_ + static_cast<double>(count));
+    }
+
+private:
+    void refill(clock_type::time_point now)
+    {
+        if (rate_ <= 0.0) {
+            tokens_ = burst_;
+        } else if (now > last_refill_) {
+            auto elapsed = std::chrono::duration<double>(now - last_refill_).count();
+            tokens_      = std::min(burst_, tokens_ + elapsed * rate_);
+        }
+        last_refill_ = std::max(last_refill_, now);
+    }
+
+    double rate_;
+    double burst_;
+    double tokens_;
+    clock_type::time_point last_refill_;
+};
+} // namespace tsvetkov
@@ -0,0 +1,196 @@
+#include "fleet_index.hpp"
+
+#include <algorithm>
+#include <mutex>
+
+namespace tsvetkov {
+namespace {
+std::size_t popcount(const std::vector<std::uint64_t>& words)
+{
+    std::size_t result = 0;
+    for (auto word : words) {
+        result += static_cast<std::size_t>(__builtin_popcountll(word));
+    }
+    return result;
+}
+
+void set_bit(std::vector<std::uint64_t>& words, std::size_t row, bool value)
+{
+    auto bit = std::uint64_t{1} << (row % 64);
+    words[row / 64] = value ? words[row / 64] | bit : words[row / 64] & ~bit;
+}
+} // namespace
+
+std::size_t DeviceBitmap::count() const
+{
+    return popcount(words_);
+}
+
+DeviceBitmap& DeviceBitmap::operator&=(const DeviceBitmap& other)
+{
+    words_.resize(std::min(words_.size(), other.words_.size()));
+    for (std::size_t i = 0; i < words_.size(); ++i) {
+        words_[i] &= other.words_[i];
+    }
+    return *this;
+}
+
+DeviceBitmap& DeviceBitmap::operator|=(const DeviceBitmap& other)
+{
+    words_.resize(std::max(words_.size(), other.words_.size()), 0);
+    for (std::size_t i = 0; i < other.words_.size(); ++i) {
+        words_[i] |= other.words_[i];
+    }
+    return *this;
+}
+
+DeviceBitmap& DeviceBitmap::subtract(const DeviceBitmap& other)
+{
+    auto words = std::min(words_.size(), other.words_.size());
+    for (std::size_t i = 0; i < words; ++i) {
+        words_[i] &= ~other.words_[i];
+    }
+    return *this;
+}
+
+void FleetIndex::update(DeviceId id, const PinState& state)
+{
+    std::unique_lock lock(mutex_);
+    auto [it, is_new] = rows_.try_emplace(id, 0);
+    if (is_new) {
+        if (!free_rows_.empty()) {
+            it->second = free_rows_.back();
+            free_rows_.pop_back();
+        } else {
+            it->second = row_ids_.size();
+            row_ids_.emplace_back();
+            row_states_.emplace_back();
+        }
+        if (it->second / 64 >= words_) {
+            // grow every allocated column along with the rows
+            words_ = std::max<std::size_t>(words_ * 2, 16);
+            live_.words_.resize(words_, 0);
+            for (auto& column : columns_) {
+                if (!column.present.empty()) {
+                    column.present.resize(words_, 0);
+                    column.on.resize(words_, 0);
+                }
+            }
+        }
+        row_ids_[it->second] = id;
+        set_bit(live_.words_, it->second, true);
+    }
+    auto row      = it->second;
+    auto& current = row_states_[row];
+    changed_pins(current, state).for_each([&](std::uint8_t pin) {
+        assign(columns_[pin], row, state.present.test(pin), state.on.test(pin));
+    });
+    powered_outlets_ = powered_outlets_ - current.on.count() + state.on.count();
+    current          = state;
+}
+
+bool FleetIndex::remove(DeviceId id)
+{
+    std::unique_lock lock(mutex_);
+    auto it = rows_.find(id);
+    if (it == rows_.end()) {
+        return false;
+    }
+    auto row      = it->second;
+    auto& current = row_states_[row];
+    current.present.for_each([&](std::uint8_t pin) { assign(columns_[pin], row, false, false); });
+    powered_outlets_ -= current.on.count();
+    current = PinState();
+    set_bit(live_.words_, row, false);
+    free_rows_.push_back(row);
+    rows_.erase(it);
+    return true;
+}
+
+void FleetIndex::assign(Column& column, std::size_t row, bool is_present, bool is_on)
+{
+    if (column.present.empty()) {
+        column.present.resize(words_, 0);
+        column.on.resize(words_, 0);
+    }
+    set_bit(column.present, row, is_present);
+    set_bit(column.on, row, is_on);
+}
+
+std::size_t FleetIndex::size() const
+{
+    std::shared_lock lock(mutex_);
+    return rows_.size();
+}
+
+std::size_t FleetIndex::powered_outlets() const
+{
+    std::shared_lock lock(mutex_);
+    return powered_outlets_;
+}
+
+std::size_t FleetIndex::count(std::uint8_t pin, Status status) const
+{
+    std::shared_lock lock(mutex_);
+    const auto& column = columns_[pin];
+    if (status == Status::On) {
+        return popcount(column.on);
+    }
+    std::size_t result = 0;
+    for (std::size_t i = 0; i < column.present.size(); ++i) {
+        result += static_cast<std::size_t>(__builtin_popcountll(column.present[i] & ~column.on[i]));
+    }
+    return result;
+}
+
+DeviceBitmap FleetIndex::select(std::uint8_t pin, Status status) const
+{
+    return select({Condition{pin, status}});
+}
+
+std::size_t FleetIndex::count(std::initializer_list<Condition> conditions) const
+{
+    std::shared_lock lock(mutex_);
+    return select_locked(conditions).count();
+}
+
+DeviceBitmap FleetIndex::select(std::initializer_list<Condition> conditions) const
+{
+    std::shared_lock lock(mutex_);
+    return select_locked(conditions);
+}
+
+DeviceBitmap FleetIndex::select_locked(std::initializer_list<Condition> conditions) const
+{
+    auto result = live_;
+    for (const auto& condition : conditions) {
+        const auto& column = columns_[condition.pin];
+        if (column.present.empty()) {
+            return DeviceBitmap(words_);
+        }
+        auto& words = result.words_;
+        if (condition.status == Status::On) {
+            for (std::size_t i = 0; i < words.size(); ++i) {
+                words[i] &= column.on[i];
+            }
+        } else {
+            for (std::size_t i = 0; i < words.size(); ++i) {
+                words[i] &= column.present[i] & ~column.on[i];
+            }
+        }
+    }
+    return result;
+}
+
+std::vector<DeviceId> FleetIndex::device_ids(const DeviceBitmap& rows) const
+{
+    std::vector<DeviceId> result;
+    std::shared_lock lock(mutex_);
+    rows.for_each([&](std::size_t row) {
+        if (row < row_ids_.size() && live_.test(row)) {
+            result.push_back(row_ids_[row]);
+        }
+    });
+    return result;
+}
+} // namespace tsvetkov
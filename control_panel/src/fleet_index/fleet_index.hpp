@@ -0,0 +1,110 @@
+#pragma once
+
+#include "client/pin_state.hpp"
+#include "common/device_id.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace tsvetkov {
+// Set of rows of a FleetIndex, one bit per row. Operations are plain loops over 64-bit words that the compiler
+// vectorizes.
+class DeviceBitmap
+{
+public:
+    DeviceBitmap() = default;
+    explicit DeviceBitmap(std::size_t words) : words_(words, 0) {}
+
+    std::size_t count() const;
+
+    bool test(std::size_t row) const
+    {
+        return row / 64 < words_.size() && ((words_[row / 64] >> (row % 64)) & 1u) != 0;
+    }
+
+    DeviceBitmap& operator&=(const DeviceBitmap& other);
+    DeviceBitmap& operator|=(const DeviceBitmap& other);
+    // Removes the rows of `other`.
+    DeviceBitmap& subtract(const DeviceBitmap& other);
+
+    // Calls f(row) for every row of the set in ascending order.
+    template<typename F>
+    void for_each(F&& f) const
+    {
+        for (std::size_t word = 0; word < words_.size(); ++word) {
+            for (auto bits = words_[word]; bits != 0; bits &= bits - 1) {
+                f(word * 64 + static_cast<std::size_t>(__builtin_ctzll(bits)));
+            }
+        }
+    }
+
+private:
+    friend class FleetIndex;
+
+    std::vector<std::uint64_t> words_;
+};
+
+// Pin states of every device of a site stored column-wise: per pin, one bitmap over all devices for "has the pin"
+// and one for "the pin is on". Each device owns a row; a status notification only rewrites the bits of the pins that
+// changed. Questions like "which devices have pin 3 on" or "how many outlets are powered" are then a few bitmap
+// ANDs and popcounts over the whole fleet instead of a walk over the clients. Columns of pins no device has take no
+// memory. Thread-safe: updates are exclusive, queries shared. Feed it from ClientPool::add_status_handler().
+class FleetIndex
+{
+public:
+    using Status = PinState::Status;
+
+    struct Condition
+    {
+        std::uint8_t pin;
+        Status status;
+    };
+
+    FleetIndex() = default;
+
+    FleetIndex(const FleetIndex&) = delete;
+    FleetIndex& operator=(const FleetIndex&) = delete;
+
+    void update(DeviceId id, const PinState& state);
+    // Forget the device, e.g. when it is removed from the pool; its row is reused.
+    bool remove(DeviceId id);
+
+    std::size_t size() const;
+    std::size_t powered_outlets() const;
+
+    // Devices with `pin` on (off), and how many of them.
+    std::size_t count(std::uint8_t pin, Status status) const;
+    DeviceBitmap select(std::uint8_t pin, Status status) const;
+    // Devices that satisfy every condition.
+    std::size_t count(std::initializer_list<Condition> conditions) const;
+    DeviceBitmap select(std::initializer_list<Condition> conditions) const;
+
+    std::vector<DeviceId> device_ids(const DeviceBitmap& rows) const;
+
+private:
+    struct Column
+    {
+        std::vector<std::uint64_t> present;
+        std::vector<std::uint64_t> on;
+    };
+
+    DeviceBitmap select_locked(std::initializer_list<Condition> conditions) const;
+    void assign(Column& column, std::size_t row, bool is_present, bool is_on);
+
+    mutable std::shared_mutex mutex_;
+    std::unordered_map<DeviceId, std::size_t> rows_;
+    // Per row: the device and its last state.
+    std::vector<DeviceId> row_ids_;
+    std::vector<PinState> row_states_;
+    std::vector<std::size_t> free_rows_;
+    DeviceBitmap live_;
+    std::array<Column, PinMask::max_pins> columns_;
+    std::size_t words_           = 0;
+    std::size_t powered_outlets_ = 0;
+};
+} // namespace tsvetkov
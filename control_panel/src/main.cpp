@@ -10,13 +10,22 @@
 #include <cxxopts.hpp>
 
 #include "client/client.hpp"
+#include "client_finder/cidr_range.hpp"
 #include "client_finder/client_finder.hpp"
+#include "client_finder/device_cache.hpp"
+#include "client_pool/client_pool.hpp"
+#include "common/logger.hpp"
+#include "fleet_index/fleet_index.hpp"
 #include "menu/menu.hpp"
 #include "protocol/protocol.hpp"
 
+#include <chrono>
+#include <functional>
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <thread>
+#include <vector>
 
 namespace protocol = tsvetkov::protocol;
 // namespace asio     = boost::asio;
@@ -34,10 +43,21 @@ int main(int argc, char** argv)
 
     std::string remote_address;
     std::uint16_t port;
+    std::string device_cache_path;
+    tsvetkov::ClientFinderOptions client_finder_options;
     try {
         cxxopts::Options options("control_panel", "Control remote unit");
         options.add_options()("ip", "remote address", cxxopts::value<std::string>())(
-            "port", "remote port", cxxopts::value<std::uint16_t>()->default_value("2000"));
+            "port", "remote port", cxxopts::value<std::uint16_t>()->default_value("2000"))(
+            "log-level",
+            "trace, debug, info, warning, error or none",
+            cxxopts::value<std::string>()->default_value("info"))(
+            "sweep",
+            "CIDR ranges to probe one host at a time where broadcast is filtered, e.g. 10.20.0.0/16,10.21.0.0/24",
+            cxxopts::value<std::vector<std::string>>())(
+            "device-cache",
+            "devices found by earlier runs, connected to without waiting for discovery",
+            cxxopts::value<std::string>()->default_value("control_panel.devices"));
 
         auto result = options.parse(argc, argv);
 
@@ -46,8 +66,26 @@ int main(int argc, char** argv)
             return 0;
         }
 
-        remote_address = result["ip"].as<std::string>();
-        port           = result["port"].as<std::uint16_t>();
+        remote_address    = result["ip"].as<std::string>();
+        port              = result["port"].as<std::uint16_t>();
+        device_cache_path = result["device-cache"].as<std::string>();
+
+        auto log_level = tsvetkov::parse_log_level(result["log-level"].as<std::string>());
+        if (!log_level) {
+            std::cout << "Unknown log level: " << result["log-level"].as<std::string>() << std::endl;
+            return 1;
+        }
+        tsvetkov::Logger::instance().set_level(*log_level);
+
+        if (result.count("sweep")) {
+            client_finder_options.sweep_ranges = result["sweep"].as<std::vector<std::string>>();
+            for (const auto& range : client_finder_options.sweep_ranges) {
+                if (!tsvetkov::parse_cidr_range(range)) {
+                    std::cout << "Not a CIDR range: " << range << std::endl;
+                    return 1;
+                }
+            }
+        }
 
         std::cout << "Client ip:" << remote_address << std::endl;
     } catch (const std::exception& e) {
@@ -66,41 +104,78 @@ int main(int argc, char** argv)
         return static_cast<std::uint32_t>(std::stoi(i));
     };
 
-    auto found_device = [&] {
-        auto client_finder = std::make_shared<tsvetkov::ClientFinder>(io);
-
-        auto found_device_promise = std::make_shared<pc::promise<tsvetkov::FoundDevice>>();
-        auto found_device_future  = found_device_promise->get_future();
-
-        client_finder->subscribe_to_found_new_device_event(tsvetkov::action_if_exists(
-            tsvetkov::make_single_context(client_finder),
-            [found_device_promise = std::move(found_device_promise)](tsvetkov::ClientFinder* self,
-                                                                     tsvetkov::FoundDevice found_device) mutable {
-                if (found_device_promise) {
-                    std::cout << "Found device!!! ip: " << found_device.ip_address << std::endl;
-                    found_device_promise->set_value(std::move(found_device));
-                    found_device_promise.reset();
-                    self->stop();
-                }
-            }));
-
-        client_finder->start();
-        return found_device_future.get();
-    }();
+    // outlives the pool, whose clients report to it
+    tsvetkov::FleetIndex fleet_index;
+    tsvetkov::ClientPool client_pool(io, port);
+    client_pool.add_status_handler(
+        [&fleet_index](tsvetkov::DeviceId id, const tsvetkov::PinState& state) { fleet_index.update(id, state); });
+    client_pool.add_removal_handler([&fleet_index](tsvetkov::DeviceId id) { fleet_index.remove(id); });
+
+    // The first device to connect, cached or found, is the one the menu controls.
+    auto connected_promise = std::make_shared<pc::promise<tsvetkov::DeviceId>>();
+    auto connected_future  = connected_promise->get_future();
+    auto once              = std::make_shared<std::once_flag>();
+    client_pool.add_status_handler([connected_promise, once](tsvetkov::DeviceId id, const tsvetkov::PinState&) {
+        std::call_once(*once, [&] { connected_promise->set_value(id); });
+    });
+
+    // Devices of earlier runs are connected to right away; discovery runs alongside and corrects stale addresses.
+    tsvetkov::DeviceCache device_cache(device_cache_path);
+    device_cache.load();
+    for (const auto& device : device_cache.devices()) {
+        client_pool.add(device);
+    }
+    std::cout << "Cached devices: " << device_cache.size() << std::endl;
+
+    auto client_finder = std::make_shared<tsvetkov::ClientFinder>(io, client_finder_options);
+    client_finder->subscribe_to_found_new_device_event(
+        [&client_pool, &device_cache](tsvetkov::FoundDevice found_device) {
+            std::cout << "Found device!!! ip: " << found_device.ip_address << std::endl;
+            client_pool.add_or_move(found_device);
+            device_cache.update(found_device);
+        });
+    client_finder->subscribe_to_address_changed_event(
+        [&client_pool, &device_cache](tsvetkov::FoundDevice found_device, std::string) {
+            client_pool.add_or_move(found_device);
+            device_cache.update(found_device);
+        });
+    // A device gone from the network leaves the pool, and with it the fleet index, until it is found again.
+    client_finder->subscribe_to_device_expired_event([&client_pool, &device_cache](tsvetkov::FoundDevice device) {
+        auto id = tsvetkov::make_device_id(device.high_device_id, device.low_device_id);
+        client_pool.remove(id).detach();
+        device_cache.remove(id);
+    });
+
+    // Written every few seconds while discovery reports changes, and on exit.
+    asio::steady_timer cache_timer(io);
+    std::function<void()> save_device_cache = [&] {
+        cache_timer.expires_after(std::chrono::seconds(5));
+        cache_timer.async_wait([&](const std::error_code& ec) {
+            if (!ec) {
+                device_cache.save();
+                save_device_cache();
+            }
+        });
+    };
+    save_device_cache();
 
-    auto client = std::make_shared<tsvetkov::Client>(io, found_device.ip_address, port);
+    client_finder->start();
+    auto client = client_pool.find(connected_future.get());
 
-    menu.add_item("All On", [&client] { client->send_all_on(); });
-    menu.add_item("All Off", [&client] { client->send_all_off(); });
+    menu.add_item("All On", [&client_pool] { client_pool.async_all_on().get(); });
+    menu.add_item("All Off", [&client_pool] { client_pool.async_all_off().get(); });
+    menu.add_item("Fleet status", [&fleet_index] {
+        std::cout << "devices: " << fleet_index.size() << ", powered outlets: " << fleet_index.powered_outlets()
+                  << std::endl;
+    });
 
-    auto smart_power_status_future = client->async_connect();
+    auto pin_state_future = client->async_connect();
 
     try {
-        auto smart_power_status = smart_power_status_future.get();
-        for (const auto& pair : smart_power_status.status) {
-            auto pin = pair.first;
+        auto pin_state = pin_state_future.get();
+        pin_state.present.for_each([&](std::uint8_t pin) {
             menu.add_item("Inversion " + std::to_string(pin), [&client, pin] { client->inversion(pin); });
-        }
+        });
     } catch (const std::exception& e) {
         std::cout << "Connection error: " << e.what() << std::endl;
     }
@@ -114,12 +189,17 @@ int main(int argc, char** argv)
         std::cout << menu.str();
         std::size_t i = get_number();
         std::cout << "selected: " << i << std::endl;
-        menu.item(i);
+        try {
+            menu.item(i);
+        } catch (const std::exception& e) {
+            std::cout << "Command error: " << e.what() << std::endl;
+        }
     }
 
     work_guard.reset();
     io.stop();
     asio_worker.join();
+    device_cache.save();
 
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,54 @@
+#include "command_plan.hpp"
+
+namespace tsvetkov {
+namespace {
+void append_inversions(const PinMask& pins, std::vector<PlannedCommand>& commands)
+{
+    pins.for_each([&](std::uint8_t pin) { commands.push_back(PlannedCommand{Command::Type::Inversion, pin}); });
+}
+} // namespace
+
+std::vector<PlannedCommand> plan_commands(const PinState& observed, const PinState& desired)
+{
+    // on-mask of the strip once every desired pin is reached, undesired pins unchanged
+    auto target   = ((observed.on & ~desired.present) | desired.on) & observed.present;
+    auto differ   = target ^ observed.on;
+    auto off      = observed.present & ~target;
+    auto n_on     = target.count();
+    auto n_off    = off.count();
+    auto n_differ = differ.count();
+
+    // all on costs one command plus one inversion per pin that must end up off, and vice versa
+    std::vector<PlannedCommand> commands;
+    if (n_differ <= 1 + n_off && n_differ <= 1 + n_on) {
+        append_inversions(differ, commands);
+    } else if (n_off <= n_on) {
+        commands.push_back(PlannedCommand{Command::Type::AllOn, 0});
+        append_inversions(off, commands);
+    } else {
+        commands.push_back(PlannedCommand{Command::Type::AllOff, 0});
+        append_inversions(target, commands);
+    }
+    return commands;
+}
+
+PinState apply_commands(PinState state, const std::vector<PlannedCommand>& commands)
+{
+    for (const auto& command : commands) {
+        switch (command.type) {
+        case Command::Type::AllOn:
+            state.on = state.present;
+            break;
+        case Command::Type::AllOff:
+            state.on = PinMask();
+            break;
+        case Command::Type::Inversion:
+            if (state.has(command.pin)) {
+                state.on.flip(command.pin);
+            }
+            break;
+        }
+    }
+    return state;
+}
+} // namespace tsvetkov
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "client/command.hpp"
+#include "client/pin_state.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace tsvetkov {
+struct PlannedCommand
+{
+    Command::Type type;
+    std::uint8_t pin = 0;
+
+    bool operator==(const PlannedCommand& other) const
+    {
+        return type == other.type && (type != Command::Type::Inversion || pin == other.pin);
+    }
+};
+
+// Shortest command sequence taking a strip from `observed` to `desired`: either one inversion per differing pin, or
+// all on / all off followed by inversions of the pins that must end up the other way. Pins absent from `desired`
+// keep their observed state; pins absent from `observed` are unknown to the strip and ignored. Empty when the strip
+// is already there.
+std::vector<PlannedCommand> plan_commands(const PinState& observed, const PinState& desired);
+
+// State of the strip after `commands`, applied in order to `state`.
+PinState apply_commands(PinState state, const std::vector<PlannedCommand>& commands);
+} // namespace tsvetkov
@@ -0,0 +1,151 @@
+#include "reconciler.hpp"
+
+#include "client/fan_out.hpp"
+
+#include <stdexcept>
+
+namespace tsvetkov {
+Reconciler::Reconciler(ClientPool& pool, Options options) : pool_(pool), options_(options) {}
+
+std::shared_ptr<Reconciler> Reconciler::create(ClientPool& pool, Options options)
+{
+    auto reconciler = std::make_shared<Reconciler>(pool, options);
+    pool.add_status_handler([weak_self = std::weak_ptr<Reconciler>(reconciler)](DeviceId id, const PinState& state) {
+        if (auto self = weak_self.lock()) {
+            self->on_status(id, state);
+        }
+    });
+    return reconciler;
+}
+
+void Reconciler::set_desired(DeviceId id, std::uint8_t pin, protocol::SmartPowerStatus::Status status)
+{
+    PinState desired;
+    desired.set(pin, status);
+    set_desired(id, desired);
+}
+
+void Reconciler::set_desired(DeviceId id, const PinState& desired)
+{
+    std::unique_lock lock(mutex_);
+    auto& device = devices_[id];
+    device.desired.merge(desired);
+    converge(id, device, lock);
+}
+
+void Reconciler::clear_desired(DeviceId id)
+{
+    std::lock_guard lock_guard(mutex_);
+    auto it = devices_.find(id);
+    if (it != devices_.end()) {
+        it->second.desired = PinState();
+    }
+}
+
+std::optional<PinState> Reconciler::observed(DeviceId id) const
+{
+    std::lock_guard lock_guard(mutex_);
+    auto it = devices_.find(id);
+    return it == devices_.end() ? std::nullopt : it->second.observed;
+}
+
+bool Reconciler::is_converged(DeviceId id) const
+{
+    std::lock_guard lock_guard(mutex_);
+    auto it = devices_.find(id);
+    if (it == devices_.end() || !it->second.observed || it->second.is_in_flight) {
+        return false;
+    }
+    return plan_commands(*it->second.observed, it->second.desired).empty();
+}
+
+ReconcilerStats Reconciler::stats() const
+{
+    std::lock_guard lock_guard(mutex_);
+    return stats_;
+}
+
+void Reconciler::on_status(DeviceId id, const PinState& state)
+{
+    std::unique_lock lock(mutex_);
+    auto& device = devices_[id];
+    if (device.is_in_flight) {
+        device.observed_in_flight = state;
+        return;
+    }
+    device.observed = state;
+    device.is_stale = false;
+    converge(id, device, lock);
+}
+
+// Called with the lock held; unlocks it to send.
+void Reconciler::converge(DeviceId id, Device& device, std::unique_lock<std::mutex>& lock)
+{
+    if (device.is_in_flight || device.is_stale || !device.observed) {
+        return;
+    }
+    auto commands = plan_commands(*device.observed, device.desired);
+    if (commands.empty()) {
+        return;
+    }
+    auto predicted      = apply_commands(*device.observed, commands);
+    device.is_in_flight = true;
+    ++stats_.plans;
+    stats_.commands += commands.size();
+    ++stats_.devices_in_flight;
+    lock.unlock();
+    send(id, commands, std::move(predicted));
+}
+
+void Reconciler::send(DeviceId id, const std::vector<PlannedCommand>& commands, PinState predicted)
+{
+    auto client = pool_.find(id);
+    if (!client) {
+        finish(id, false, std::move(predicted));
+        return;
+    }
+    // Submitted from this thread in order, so the client writes them in order.
+    fan_out(commands,
+            [this, &client](const PlannedCommand& command) {
+                switch (command.type) {
+                case Command::Type::AllOn:
+                    return client->async_send_all_on(options_.command_timeout, options_.lane);
+                case Command::Type::AllOff:
+                    return client->async_send_all_off(options_.command_timeout, options_.lane);
+                case Command::Type::Inversion:
+                    return client->async_inversion(command.pin, options_.command_timeout, options_.lane);
+                }
+                throw std::invalid_argument("unknown command type");
+            })
+        .then([weak_self = weak_from_this(), id, predicted = std::move(predicted)](
+                  pc::future<ClientPool::results_type> future) mutable {
+            auto self = weak_self.lock();
+            if (!self) {
+                return;
+            }
+            auto results = future.get();
+            self->finish(id, count_succeeded(results) == results.size(), std::move(predicted));
+        })
+        .detach();
+}
+
+void Reconciler::finish(DeviceId id, bool succeeded, PinState predicted)
+{
+    std::unique_lock lock(mutex_);
+    auto& device        = devices_[id];
+    device.is_in_flight = false;
+    --stats_.devices_in_flight;
+    auto observed_in_flight = std::move(device.observed_in_flight);
+    device.observed_in_flight.reset();
+    if (succeeded) {
+        device.observed = std::move(predicted);
+    } else if (observed_in_flight) {
+        ++stats_.failed_plans;
+        device.observed = std::move(*observed_in_flight);
+    } else {
+        ++stats_.failed_plans;
+        device.is_stale = true;
+    }
+    converge(id, device, lock);
+}
+} // namespace tsvetkov
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "client_pool/client_pool.hpp"
+#include "common/device_id.hpp"
+#include "reconciler/command_plan.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace tsvetkov {
+struct ReconcilerStats
+{
+    // Command sequences started, commands they held, and sequences with a failed or rejected command.
+    std::uint64_t plans        = 0;
+    std::uint64_t commands     = 0;
+    std::uint64_t failed_plans = 0;
+    // Devices with a sequence in flight now.
+    std::size_t devices_in_flight = 0;
+};
+
+// Desired-state store over the clients of a ClientPool. Callers say which state a pin should be in; the reconciler
+// plans the shortest all on / all off / inversion sequence from the last status the strip reported (plan_commands)
+// and sends it whenever the two differ: after set_desired(), after every status notification and so after every
+// reconnect. Only the device an event is about is looked at, so the cost of converging does not depend on the size
+// of the fleet.
+//
+// One sequence per device is in flight at a time. When all of its commands succeed the strip is assumed to be in the
+// planned state, and notifications that arrived meanwhile are dropped as they may predate the sequence. When one
+// fails the outcome is unknown: the device is planned again from the last notification received during the
+// sequence, or else waits for the next one, so a toggle is never repeated on a guess. Thread-safe. Create with
+// create() before adding devices to the pool: it adds a status handler to the pool.
+class Reconciler : public std::enable_shared_from_this<Reconciler>
+{
+public:
+    struct Options
+    {
+        // Reconciliation is background traffic: keep it out of the way of interactive commands.
+        Lane lane = Lane::Bulk;
+        // Timeout of every command sent, see Client::async_inversion.
+        std::chrono::steady_clock::duration command_timeout = std::chrono::seconds(5);
+    };
+
+    Reconciler(ClientPool& pool, Options options);
+
+    static std::shared_ptr<Reconciler> create(ClientPool& pool, Options options = Options{});
+
+    void set_desired(DeviceId id, std::uint8_t pin, protocol::SmartPowerStatus::Status status);
+    // Merged into what is already desired for the device.
+    void set_desired(DeviceId id, const PinState& desired);
+    // The device's pins are left as they are from now on.
+    void clear_desired(DeviceId id);
+
+    std::optional<PinState> observed(DeviceId id) const;
+    // True when the device reported (or was driven into) every desired state and nothing is in flight.
+    bool is_converged(DeviceId id) const;
+
+    ReconcilerStats stats() const;
+
+private:
+    struct Device
+    {
+        PinState desired;
+        std::optional<PinState> observed;
+        // Observed state arrived while a sequence was in flight.
+        std::optional<PinState> observed_in_flight;
+        bool is_in_flight = false;
+        // The last sequence failed: the observed state is no longer trusted.
+        bool is_stale = false;
+    };
+
+    void on_status(DeviceId id, const PinState& state);
+    void converge(DeviceId id, Device& device, std::unique_lock<std::mutex>& lock);
+    void send(DeviceId id, const std::vector<PlannedCommand>& commands, PinState predicted);
+    void finish(DeviceId id, bool succeeded, PinState predicted);
+
+    ClientPool& pool_;
+    const Options options_;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<DeviceId, Device> devices_;
+    ReconcilerStats stats_;
+};
+} // namespace tsvetkov
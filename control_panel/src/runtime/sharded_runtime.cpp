@@ -0,0 +1,89 @@
+#include "sharded_runtime.hpp"
+
+#include "common/logger.hpp"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <algorithm>
+
+namespace tsvetkov {
+namespace {
+void pin_to_core(std::thread& thread, std::size_t core)
+{
+#ifdef __linux__
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(core, &cpu_set);
+    if (auto error = pthread_setaffinity_np(thread.native_handle(), sizeof(cpu_set), &cpu_set)) {
+        log_warning("sharded_runtime", "failed to pin a shard to core ", core, ": ", error);
+    }
+#else
+    (void)thread;
+    (void)core;
+#endif
+}
+} // namespace
+
+ShardedRuntime::ShardedRuntime(std::size_t shards, bool pin_threads)
+{
+    auto cores = std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+    if (shards == 0) {
+        shards = cores;
+    }
+    shards_.reserve(shards);
+    for (std::size_t i = 0; i < shards; ++i) {
+        shards_.push_back(std::make_unique<Shard>());
+        auto& shard  = *shards_.back();
+        shard.thread = std::thread([&shard] { shard.io.run(); });
+        if (pin_threads) {
+            pin_to_core(shard.thread, i % cores);
+        }
+    }
+}
+
+ShardedRuntime::~ShardedRuntime()
+{
+    stop();
+}
+
+std::size_t ShardedRuntime::size() const
+{
+    return shards_.size();
+}
+
+std::size_t ShardedRuntime::shard_index(DeviceId id) const
+{
+    return static_cast<std::size_t>(hash_device_id(id) % shards_.size());
+}
+
+asio::io_context& ShardedRuntime::shard(std::size_t index)
+{
+    return shards_[index]->io;
+}
+
+asio::io_context& ShardedRuntime::shard_for(DeviceId id)
+{
+    return shard(shard_index(id));
+}
+
+SerialExecutor ShardedRuntime::executor_for(DeviceId id)
+{
+    return SerialExecutor::single_threaded(shard_for(id));
+}
+
+void ShardedRuntime::stop()
+{
+    for (auto& shard : shards_) {
+        shard->work_guard.reset();
+        shard->io.stop();
+    }
+    for (auto& shard : shards_) {
+        if (shard->thread.joinable()) {
+            shard->thread.join();
+        }
+    }
+}
+} // namespace tsvetkov
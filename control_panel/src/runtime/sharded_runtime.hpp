@@ -0,0 +1,50 @@
+#pragma once
+
+#include "asio.hpp"
+
+#include "common/device_id.hpp"
+#include "common/serial_executor.hpp"
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace tsvetkov {
+// N io_contexts, each run by its own thread pinned to its own core. A connection is assigned to a shard by the hash
+// of its device id and all of its handlers run on that shard's thread, so they need no strand and never migrate
+// between cores.
+class ShardedRuntime
+{
+public:
+    // shards == 0 means one shard per hardware thread.
+    explicit ShardedRuntime(std::size_t shards = 0, bool pin_threads = true);
+    ~ShardedRuntime();
+
+    ShardedRuntime(const ShardedRuntime&) = delete;
+    ShardedRuntime& operator=(const ShardedRuntime&) = delete;
+
+    std::size_t size() const;
+
+    std::size_t shard_index(DeviceId id) const;
+    asio::io_context& shard(std::size_t index);
+    asio::io_context& shard_for(DeviceId id);
+
+    // Executor for an object that lives on the shard of `id`.
+    SerialExecutor executor_for(DeviceId id);
+
+    // Stops every shard and joins the threads. Called by the destructor.
+    void stop();
+
+private:
+    struct Shard
+    {
+        Shard() : io(1), work_guard(io.get_executor()) {}
+
+        asio::io_context io;
+        asio::executor_work_guard<asio::io_context::executor_type> work_guard;
+        std::thread thread;
+    };
+
+    std::vector<std::unique_ptr<Shard>> shards_;
+};
+} // namespace tsvetkov
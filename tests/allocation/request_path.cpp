@@ -0,0 +1,159 @@
+#include "catch2/catch.hpp"
+
+#include "client/client.hpp"
+#include "client/frame.hpp"
+#include "common/circular_queue.hpp"
+#include "common/request_table.hpp"
+#include "fixture/fake_device.hpp"
+#include "fixture/test_utils.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+// Replaces the global allocator of this executable only, which is why these tests don't live in protocol_tests.
+// Only threads that opted in are counted, so the fake device allocating on its own threads doesn't show up.
+namespace {
+std::atomic<std::size_t> allocation_count{0};
+thread_local bool counted_thread = false;
+} // namespace
+
+void* operator new(std::size_t size)
+{
+    if (counted_thread) {
+        allocation_count.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (auto ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+namespace {
+struct PendingCommand
+{
+    std::uint32_t id = 0;
+    int result       = 0;
+};
+} // namespace
+
+TEST_CASE("Request table and frame queue do not allocate in steady state", "[allocation]")
+{
+    counted_thread = true;
+
+    tsvetkov::RequestTable<PendingCommand> table(1024);
+    tsvetkov::CircularQueue<tsvetkov::Frame> output_buffer(64);
+    std::array<char, 13> packet{};
+
+    auto round_trip = [&](std::uint32_t first_id) {
+        // a burst of commands is queued and encoded...
+        for (std::uint32_t id = first_id; id < first_id + 64; ++id) {
+            table.insert(id, PendingCommand{id});
+            output_buffer.emplace_back(packet);
+        }
+        // ...written...
+        while (!output_buffer.empty()) {
+            output_buffer.pop_front();
+        }
+        // ...and answered
+        for (std::uint32_t id = first_id; id < first_id + 64; ++id) {
+            table.take(id);
+        }
+    };
+
+    round_trip(0);
+
+    auto counted = allocation_count.load();
+    PendingCommand* volatile probe = new PendingCommand;
+    delete probe;
+    REQUIRE(allocation_count.load() == counted + 1);
+
+    auto before = allocation_count.load();
+    for (std::uint32_t i = 1; i < 10000; ++i) {
+        round_trip(i * 64);
+    }
+    auto after = allocation_count.load();
+    counted_thread = false;
+
+    REQUIRE(after == before);
+    REQUIRE(table.size() == 0);
+}
+
+TEST_CASE("Client: allocations per command in steady state", "[allocation][client]")
+{
+    using namespace tsvetkov;
+    test::register_endian_conversion();
+
+    constexpr std::size_t batch   = 64;
+    constexpr std::size_t batches = 200;
+
+    test::FakeDevice device;
+
+    asio::io_context io;
+    asio::executor_work_guard<asio::io_context::executor_type> work_guard(io.get_executor());
+    auto asio_worker = std::thread([&] {
+        counted_thread = true;
+        io.run();
+    });
+
+    ClientOptions options;
+    options.coalesce_commands = false;
+    auto client               = std::make_shared<Client>(io, "127.0.0.1", device.port(), options);
+    client->connect();
+
+    std::vector<pc::future<Client::command_result_type>> results;
+    results.reserve(batch);
+    auto run_batches = [&](std::size_t count) {
+        for (std::size_t b = 0; b < count; ++b) {
+            for (std::size_t i = 0; i < batch; ++i) {
+                results.push_back(client->async_inversion(static_cast<std::uint8_t>(i % 8)));
+            }
+            for (auto& result : results) {
+                REQUIRE_FALSE(result.get());
+            }
+            results.clear();
+        }
+    };
+
+    // connects and grows every buffer and pool to its working size
+    run_batches(batches / 4);
+
+    auto drains_before = client->stats().command_drains;
+    counted_thread     = true;
+    auto before        = allocation_count.load();
+    run_batches(batches);
+    auto after     = allocation_count.load();
+    counted_thread = false;
+    auto drains    = client->stats().command_drains - drains_before;
+
+    // Two allocations are left, both on the submitting thread:
+    // - per command, the shared state of its pc::promise, made when submit() resets the promise of a recycled node;
+    // - per wakeup of the client's executor, the asio operation of its post. It is freed into the executor thread's
+    //   recycling cache, so the submitting thread never gets it back.
+    // The request table, frame queue, command nodes, timers and the socket handlers on the executor are all reused.
+    auto commands = batch * batches;
+    WARN("allocations per command: " << static_cast<double>(after - before) / static_cast<double>(commands)
+                                     << ", commands per drain: " << static_cast<double>(commands) / drains);
+    REQUIRE(after - before == commands + drains);
+
+    client.reset();
+    work_guard.reset();
+    io.stop();
+    asio_worker.join();
+}
@@ -0,0 +1,63 @@
+#include "catch2/catch.hpp"
+
+#include "client/fan_out.hpp"
+#include "client_pool/client_pool.hpp"
+#include "fixture/fake_device.hpp"
+#include "fixture/test_utils.hpp"
+
+#include <chrono>
+#include <thread>
+
+TEST_CASE("Client pool: scaling", "[.][benchmark]")
+{
+    using namespace tsvetkov;
+    test::register_endian_conversion();
+
+    for (std::size_t connections : {1000, 10000}) {
+        // both ends of every connection live in this process
+        if (!test::raise_open_files_limit(2 * connections + 256)) {
+            WARN("Not enough file descriptors for " << connections << " connections, raise `ulimit -n`");
+            continue;
+        }
+
+        test::FakeDevice device;
+
+        asio::io_context io;
+        asio::executor_work_guard<asio::io_context::executor_type> work_guard(io.get_executor());
+        auto asio_worker = std::thread([&] { io.run(); });
+
+        // one fake device answers for every strip, under ids of its own
+        ClientOptions options;
+        options.verify_device_id = false;
+        ClientPool pool(io, device.port(), options);
+
+        auto start = std::chrono::steady_clock::now();
+        for (std::uint32_t i = 0; i < connections; ++i) {
+            pool.add(FoundDevice(protocol::DeviceType::SmartPowerStrip, 0, i, "127.0.0.1"));
+        }
+        REQUIRE(pool.size() == connections);
+        REQUIRE(test::wait_until([&] { return pool.count(ConnectionState::Connected) == connections; },
+                                 std::chrono::seconds(60)));
+        auto connect_time = std::chrono::steady_clock::now() - start;
+        WARN(connections << " connections established in "
+                         << std::chrono::duration_cast<std::chrono::milliseconds>(connect_time).count() << " ms");
+
+        BENCHMARK("lookup, connections: " + std::to_string(connections))
+        {
+            return pool.find(make_device_id(0, static_cast<std::uint32_t>(connections / 2)));
+        };
+
+        BENCHMARK("broadcast all off, connections: " + std::to_string(connections))
+        {
+            auto results = pool.async_all_off().get();
+            return count_succeeded(results);
+        };
+
+        auto results = pool.async_all_on().get();
+        REQUIRE(count_succeeded(results) == connections);
+
+        work_guard.reset();
+        io.stop();
+        asio_worker.join();
+    }
+}
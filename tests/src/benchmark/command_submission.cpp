@@ -0,0 +1,80 @@
+#include "catch2/catch.hpp"
+
+#include "client/client.hpp"
+#include "client/fan_out.hpp"
+#include "fixture/fake_device.hpp"
+#include "fixture/test_utils.hpp"
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+constexpr std::size_t commands_per_producer = 2000;
+
+// `producers` threads submit inversions to one client at once; returns how many completed successfully.
+std::size_t submit_from(tsvetkov::Client& client, std::size_t producers)
+{
+    using results_type = std::vector<pc::future<tsvetkov::Client::command_result_type>>;
+
+    std::vector<results_type> results(producers);
+    std::vector<std::thread> threads;
+    for (std::size_t producer = 0; producer < producers; ++producer) {
+        threads.emplace_back([&client, &results = results[producer]] {
+            results.reserve(commands_per_producer);
+            for (std::size_t i = 0; i < commands_per_producer; ++i) {
+                results.push_back(client.async_inversion(static_cast<std::uint8_t>(i % 8)));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    std::size_t succeeded = 0;
+    for (auto& producer_results : results) {
+        succeeded += tsvetkov::count_succeeded(producer_results);
+    }
+    return succeeded;
+}
+} // namespace
+
+TEST_CASE("Command submission: contention", "[.][benchmark]")
+{
+    using namespace tsvetkov;
+    test::register_endian_conversion();
+
+    test::FakeDevice device;
+
+    asio::io_context io(1);
+    asio::executor_work_guard<asio::io_context::executor_type> work_guard(io.get_executor());
+    auto asio_worker = std::thread([&] { io.run(); });
+
+    // every command of a round is in flight at once and reaches the device: nothing is coalesced or refused
+    constexpr std::size_t max_producers = 16;
+    ClientOptions options;
+    options.coalesce_commands    = false;
+    options.max_pending_requests = max_producers * commands_per_producer;
+    options.max_queued_frames    = max_producers * commands_per_producer;
+    auto client                  = std::make_shared<Client>(io, "127.0.0.1", device.port(), options);
+    client->connect();
+    REQUIRE(test::wait_until([&] { return client->connection_state() == ConnectionState::Connected; },
+                             std::chrono::seconds(5)));
+
+    for (std::size_t producers = 1; producers <= max_producers; producers *= 2) {
+        BENCHMARK("Client::submit, producers: " + std::to_string(producers))
+        {
+            return submit_from(*client, producers);
+        };
+        REQUIRE(submit_from(*client, producers) == producers * commands_per_producer);
+    }
+
+    auto stats = client->stats();
+    WARN("commands per drain: " << static_cast<double>(stats.commands_drained) / stats.command_drains);
+
+    client.reset();
+    work_guard.reset();
+    io.stop();
+    asio_worker.join();
+}
@@ -0,0 +1,57 @@
+#include "catch2/catch.hpp"
+
+#include "fleet_index/fleet_index.hpp"
+
+#include <random>
+
+TEST_CASE("Fleet index: queries", "[.][benchmark]")
+{
+    using namespace tsvetkov;
+    using Status = FleetIndex::Status;
+
+    constexpr std::size_t devices = 100000;
+    constexpr std::uint8_t pins   = 8;
+
+    FleetIndex index;
+    std::minstd_rand random(42);
+    for (DeviceId id = 0; id < devices; ++id) {
+        PinState state;
+        for (std::uint8_t pin = 0; pin < pins; ++pin) {
+            state.set(pin, random() % 2 ? Status::On : Status::Off);
+        }
+        index.update(id, state);
+    }
+    REQUIRE(index.size() == devices);
+
+    BENCHMARK("devices with pin 3 on, 100k devices")
+    {
+        return index.count(3, Status::On);
+    };
+
+    BENCHMARK("devices with pin 3 on and pin 5 off, 100k devices")
+    {
+        return index.count({{3, Status::On}, {5, Status::Off}});
+    };
+
+    BENCHMARK("select pin 3 on | pin 4 on, 100k devices")
+    {
+        auto rows = index.select(3, Status::On);
+        rows |= index.select(4, Status::On);
+        return rows.count();
+    };
+
+    BENCHMARK("powered outlets, 100k devices")
+    {
+        return index.powered_outlets();
+    };
+
+    DeviceId next = 0;
+    BENCHMARK("update one device")
+    {
+        PinState state;
+        for (std::uint8_t pin = 0; pin < pins; ++pin) {
+            state.set(pin, random() % 2 ? Status::On : Status::Off);
+        }
+        index.update(next++ % devices, state);
+    };
+}
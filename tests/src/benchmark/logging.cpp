@@ -0,0 +1,72 @@
+#include "catch2/catch.hpp"
+
+#include "common/logger.hpp"
+
+#include <atomic>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Cost on the logging (io) thread of one status-notification line while other threads log too: a flushed stream
+// write, as `std::cout << ... << std::endl` does, against the asynchronous logger writing to the same file.
+TEST_CASE("Logging: io thread cost per line under load", "[.][benchmark]")
+{
+    using namespace tsvetkov;
+    constexpr int background_threads = 3;
+
+    std::ofstream stream("/dev/null");
+    std::mutex stream_mutex;
+    auto* file = std::fopen("/dev/null", "w");
+    auto previous_level = Logger::instance().level();
+    Logger::instance().set_level(LogLevel::Info);
+    auto previous_sink = Logger::instance().set_sink([file](std::string_view lines) {
+        std::fwrite(lines.data(), 1, lines.size(), file);
+        std::fflush(file);
+    });
+
+    std::atomic<bool> is_done{false};
+    std::atomic<bool> is_async{false};
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread < background_threads; ++thread) {
+        threads.emplace_back([&, thread] {
+            for (std::uint32_t i = 0; !is_done.load(std::memory_order_relaxed); ++i) {
+                if (is_async.load(std::memory_order_relaxed)) {
+                    log_info("client", "smart_power_status, pin: ", thread, " status: On, id: ", i);
+                } else {
+                    std::lock_guard lock_guard(stream_mutex);
+                    stream << "smart_power_status, pin: " << thread << " status: On, id: " << i << std::endl;
+                }
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+        });
+    }
+
+    std::uint32_t id = 0;
+    BENCHMARK("std::endl to a file, shared stream")
+    {
+        std::lock_guard lock_guard(stream_mutex);
+        stream << "smart_power_status, pin: " << 3 << " status: " << "On" << ", id: " << ++id << std::endl;
+    };
+
+    is_async = true;
+    BENCHMARK("asynchronous logger")
+    {
+        log_info("client", "smart_power_status, pin: ", 3, " status: ", "On", ", id: ", ++id);
+    };
+
+    BENCHMARK("asynchronous logger, level disabled at run time")
+    {
+        log_debug("client", "smart_power_status, pin: ", 3, " status: ", "On", ", id: ", ++id);
+    };
+
+    is_done = true;
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    Logger::instance().flush();
+    Logger::instance().set_sink(std::move(previous_sink));
+    Logger::instance().set_level(previous_level);
+    std::fclose(file);
+}
@@ -0,0 +1,109 @@
+#include "boost/endian/conversion.hpp"
+#include "catch2/catch.hpp"
+
+#include "common/ring_buffer.hpp"
+#include "protocol/command_handler.hpp"
+
+#include <cstring>
+#include <string>
+#include <unordered_map>
+
+namespace protocol = tsvetkov::protocol;
+
+namespace {
+std::string make_burst(std::size_t frames)
+{
+    std::unordered_map<std::uint8_t, protocol::SmartPowerStatus::Status> status;
+    for (std::uint8_t pin = 0; pin < 8; ++pin) {
+        status.emplace(pin, pin % 2 ? protocol::SmartPowerStatus::Status::On : protocol::SmartPowerStatus::Status::Off);
+    }
+    protocol::Error error = protocol::Error::NoError;
+    auto notification     = protocol::make_smart_power_notification(error, status);
+
+    std::string burst;
+    for (std::uint32_t i = 0; i < frames; ++i) {
+        if (i % 2) {
+            burst.append(notification.data(), protocol::expected_packet_size(notification.data()));
+        } else {
+            auto ok = protocol::make_ok_response(i);
+            burst.append(ok.begin(), ok.end());
+        }
+    }
+    return burst;
+}
+
+// The previous Client::async_read: append every 1024-byte read to a string, erase each parsed frame from the front.
+std::size_t parse_with_accumulate_buffer(protocol::CommandHandler& handler, const std::string& burst)
+{
+    std::size_t parsed = 0;
+    std::string accumulate_incoming_buffer;
+    for (std::size_t offset = 0; offset < burst.size(); offset += 1024) {
+        accumulate_incoming_buffer.append(burst, offset, 1024);
+        while (accumulate_incoming_buffer.size() >= protocol::Message::packet_size) {
+            auto data        = &accumulate_incoming_buffer[0];
+            auto size_packet = protocol::expected_packet_size(data);
+            if (size_packet > accumulate_incoming_buffer.size()) {
+                break;
+            }
+            handler.parse(data, accumulate_incoming_buffer.size());
+            accumulate_incoming_buffer.erase(0, size_packet);
+            ++parsed;
+        }
+    }
+    return parsed;
+}
+
+// The current Client::async_read: read into the free space of the ring, parse views in place.
+std::size_t parse_with_ring_buffer(protocol::CommandHandler& handler, const std::string& burst)
+{
+    std::size_t parsed = 0;
+    tsvetkov::RingBuffer<4096> ring;
+    std::size_t offset = 0;
+    while (offset < burst.size()) {
+        std::size_t transferred = 0;
+        for (auto region : ring.prepare()) {
+            auto n = std::min(region.size(), burst.size() - offset - transferred);
+            std::memcpy(region.data(), burst.data() + offset + transferred, n);
+            transferred += n;
+        }
+        offset += transferred;
+        ring.commit(transferred);
+        while (ring.size() >= protocol::Message::packet_size) {
+            auto size_packet = protocol::expected_packet_size(ring.peek(protocol::Message::packet_size));
+            if (size_packet > ring.size()) {
+                break;
+            }
+            handler.parse(ring.peek(size_packet), size_packet);
+            ring.consume(size_packet);
+            ++parsed;
+        }
+    }
+    return parsed;
+}
+} // namespace
+
+TEST_CASE("Receive buffer: burst parsing", "[.][benchmark]")
+{
+    protocol::register_big_endian_to_native(&boost::endian::big_to_native);
+    protocol::register_native_to_big_endian(&boost::endian::native_to_big);
+
+    protocol::CommandHandler handler;
+    handler.subscribe([](std::uint32_t, protocol::OkResponse) {});
+    handler.subscribe([](protocol::SmartPowerStatus) {});
+
+    for (std::size_t frames : {1000, 10000, 50000}) {
+        auto burst = make_burst(frames);
+
+        REQUIRE(parse_with_accumulate_buffer(handler, burst) == frames);
+        REQUIRE(parse_with_ring_buffer(handler, burst) == frames);
+
+        BENCHMARK("accumulate buffer, frames: " + std::to_string(frames))
+        {
+            return parse_with_accumulate_buffer(handler, burst);
+        };
+        BENCHMARK("ring buffer, frames: " + std::to_string(frames))
+        {
+            return parse_with_ring_buffer(handler, burst);
+        };
+    }
+}
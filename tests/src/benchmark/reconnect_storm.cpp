@@ -0,0 +1,78 @@
+#include "catch2/catch.hpp"
+
+#include "client_pool/client_pool.hpp"
+#include "fixture/fake_device.hpp"
+#include "fixture/test_utils.hpp"
+
+#include <chrono>
+#include <thread>
+
+namespace {
+// Connects `connections` clients, drops every connection on the device side and returns how long the fleet takes
+// to be fully connected again.
+std::chrono::milliseconds recovery_time(std::size_t connections, tsvetkov::ClientOptions options)
+{
+    using namespace tsvetkov;
+
+    test::FakeDevice device;
+    // it answers for every strip, under ids of its own
+    options.verify_device_id = false;
+
+    asio::io_context io;
+    asio::executor_work_guard<asio::io_context::executor_type> work_guard(io.get_executor());
+    auto asio_worker = std::thread([&] { io.run(); });
+
+    ClientPool pool(io, device.port(), options);
+    for (std::uint32_t i = 0; i < connections; ++i) {
+        pool.add(FoundDevice(protocol::DeviceType::SmartPowerStrip, 0, i, "127.0.0.1"));
+    }
+    REQUIRE(test::wait_until([&] { return pool.count(ConnectionState::Connected) == connections; },
+                             std::chrono::seconds(60)));
+
+    device.drop_all();
+    REQUIRE(test::wait_until([&] { return pool.count(ConnectionState::Connected) < connections; },
+                             std::chrono::seconds(10)));
+    auto start = std::chrono::steady_clock::now();
+    REQUIRE(test::wait_until([&] { return pool.count(ConnectionState::Connected) == connections; },
+                             std::chrono::seconds(120)));
+    auto recovery = std::chrono::steady_clock::now() - start;
+
+    work_guard.reset();
+    io.stop();
+    asio_worker.join();
+    return std::chrono::duration_cast<std::chrono::milliseconds>(recovery);
+}
+} // namespace
+
+TEST_CASE("Reconnect storm: fleet recovery", "[.][benchmark]")
+{
+    using namespace tsvetkov;
+    test::register_endian_conversion();
+
+    for (std::size_t connections : {1000, 5000}) {
+        if (!test::raise_open_files_limit(2 * connections + 256)) {
+            WARN("Not enough file descriptors for " << connections << " connections, raise `ulimit -n`");
+            continue;
+        }
+
+        ClientOptions options;
+        options.reconnect_initial_delay = std::chrono::milliseconds(100);
+        options.reconnect_max_delay     = std::chrono::seconds(2);
+
+        auto unlimited = recovery_time(connections, options);
+
+        asio::io_context limiter_io;
+        options.handshake_limiter = AdmissionLimiter::create(limiter_io, AdmissionLimiter::Options{64, 5000.0, 256.0});
+        asio::executor_work_guard<asio::io_context::executor_type> work_guard(limiter_io.get_executor());
+        auto limiter_worker = std::thread([&] { limiter_io.run(); });
+
+        auto limited = recovery_time(connections, options);
+
+        work_guard.reset();
+        limiter_io.stop();
+        limiter_worker.join();
+
+        WARN(connections << " connections, full recovery without limiter: " << unlimited.count()
+                         << " ms, with limiter: " << limited.count() << " ms");
+    }
+}
@@ -0,0 +1,58 @@
+#include "catch2/catch.hpp"
+
+#include "client/fan_out.hpp"
+#include "client_pool/client_pool.hpp"
+#include "fixture/fake_device.hpp"
+#include "fixture/test_utils.hpp"
+#include "runtime/sharded_runtime.hpp"
+
+#include <chrono>
+#include <thread>
+
+TEST_CASE("Sharded runtime: command throughput", "[.][benchmark]")
+{
+    using namespace tsvetkov;
+    test::register_endian_conversion();
+
+    const std::size_t cores       = std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+    const std::size_t connections = 512;
+    const std::size_t rounds      = 200;
+
+    REQUIRE(test::raise_open_files_limit(2 * connections + 256));
+
+    test::FakeDevice device(8, false, cores);
+
+    for (std::size_t shards = 1; shards <= cores; shards *= 2) {
+        ShardedRuntime runtime(shards);
+        // one fake device answers for every strip, under ids of its own; every command of every round is sent
+        ClientOptions options;
+        options.verify_device_id  = false;
+        options.coalesce_commands = false;
+        ClientPool pool(runtime, device.port(), options);
+
+        for (std::uint32_t i = 0; i < connections; ++i) {
+            pool.add(FoundDevice(protocol::DeviceType::SmartPowerStrip, 0, i, "127.0.0.1"));
+        }
+        REQUIRE(test::wait_until([&] { return pool.count(ConnectionState::Connected) == connections; },
+                                 std::chrono::seconds(30)));
+
+        // Keep every round in flight at once, wait only at the end.
+        auto start = std::chrono::steady_clock::now();
+        std::vector<pc::future<ClientPool::results_type>> in_flight;
+        in_flight.reserve(rounds);
+        for (std::size_t round = 0; round < rounds; ++round) {
+            in_flight.push_back(pool.async_inversion(static_cast<std::uint8_t>(round % 8)));
+        }
+        std::size_t succeeded = 0;
+        for (auto& round : in_flight) {
+            auto results = round.get();
+            succeeded += count_succeeded(results);
+        }
+        auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        REQUIRE(succeeded == connections * rounds);
+        WARN("shards: " << shards << ", commands/s: " << static_cast<std::uint64_t>(succeeded / elapsed));
+
+        runtime.stop();
+    }
+}
@@ -0,0 +1,110 @@
+#include "catch2/catch.hpp"
+
+#include "client_finder/device_cache.hpp"
+#include "client_pool/client_pool.hpp"
+#include "fixture/fake_device.hpp"
+#include "fixture/fake_site.hpp"
+#include "fixture/test_utils.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+// Starts up as main() does: the cached devices are added to the pool at once, discovery adds the ones it finds, and
+// the first command goes to the first device to connect. Returns the time from startup to that command's
+// acknowledgement. Discovery reaches the stand-in site by unicast, loopback taking no broadcast.
+std::chrono::microseconds time_to_first_command(const std::string& cache_path, std::uint64_t lost_knocks)
+{
+    using namespace tsvetkov;
+
+    test::FakeDevice device;
+    test::FakeSite site(lost_knocks);
+
+    asio::io_context io;
+    asio::executor_work_guard<asio::io_context::executor_type> work_guard(io.get_executor());
+    auto asio_worker = std::thread([&] { io.run(); });
+
+    auto start = std::chrono::steady_clock::now();
+    // one fake device answers for every strip the site reports, under ids of its own
+    ClientOptions options;
+    options.verify_device_id = false;
+    ClientPool pool(io, device.port(), options);
+    std::promise<DeviceId> connected;
+    auto connected_future = connected.get_future();
+    std::once_flag once;
+    pool.add_status_handler([&](DeviceId id, const PinState&) {
+        std::call_once(once, [&] { connected.set_value(id); });
+    });
+
+    DeviceCache cache(cache_path);
+    cache.load();
+    for (const auto& cached_device : cache.devices()) {
+        pool.add(cached_device);
+    }
+
+    ClientFinderOptions options;
+    options.broadcast_port = site.port();
+    options.listen_port    = 0;
+    options.sweep_ranges   = {"127.0.0.1"};
+    auto finder            = std::make_shared<ClientFinder>(io, options);
+    finder->subscribe_to_found_new_device_event([&](FoundDevice found_device) {
+        pool.add_or_move(found_device);
+        cache.update(found_device);
+    });
+    finder->start();
+
+    auto client = pool.find(connected_future.get());
+    client->async_send_all_on().get();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    finder->stop();
+    finder.reset();
+    work_guard.reset();
+    io.stop();
+    asio_worker.join();
+    cache.save();
+    return std::chrono::duration_cast<std::chrono::microseconds>(elapsed);
+}
+
+template<typename F>
+std::chrono::microseconds median_of(std::size_t runs, F f)
+{
+    std::vector<std::chrono::microseconds> samples;
+    for (std::size_t run = 0; run < runs; ++run) {
+        samples.push_back(f());
+    }
+    std::sort(samples.begin(), samples.end());
+    return samples[samples.size() / 2];
+}
+} // namespace
+
+TEST_CASE("Startup: time to first command, cold and warm", "[.][benchmark]")
+{
+    using namespace tsvetkov;
+    test::register_endian_conversion();
+
+    constexpr std::size_t runs = 11;
+    auto cache_path            = (std::filesystem::temp_directory_path() / "startup_benchmark.devices").string();
+
+    auto cold = median_of(runs, [&] {
+        std::remove(cache_path.c_str());
+        return time_to_first_command(cache_path, 0);
+    });
+    auto cold_lost_knock = median_of(runs, [&] {
+        std::remove(cache_path.c_str());
+        return time_to_first_command(cache_path, 1);
+    });
+    // the cache written by the last cold start; discovery is not waited for, lost knocks or not
+    auto warm = median_of(runs, [&] { return time_to_first_command(cache_path, 1); });
+    std::remove(cache_path.c_str());
+
+    WARN("time to first command, median of " << runs << " starts: cold " << cold.count()
+                                             << " us, cold with the first KnockKnock lost " << cold_lost_knock.count()
+                                             << " us, warm " << warm.count() << " us");
+}
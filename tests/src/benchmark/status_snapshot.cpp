@@ -0,0 +1,85 @@
+#include "catch2/catch.hpp"
+
+#include "client_pool/status_board.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Reading the state of every device while status notifications keep arriving: the lock-free board against the
+// mutex-guarded map it replaces.
+TEST_CASE("Status snapshot: reads under concurrent updates", "[.][benchmark]")
+{
+    using namespace tsvetkov;
+
+    constexpr std::size_t devices = 10000;
+    constexpr std::size_t writers = 2;
+
+    StatusBoard board;
+    std::vector<std::size_t> slots;
+    for (DeviceId id = 0; id < devices; ++id) {
+        slots.push_back(board.acquire(id));
+    }
+    std::mutex mutex;
+    std::unordered_map<DeviceId, DeviceSnapshot> guarded;
+    for (DeviceId id = 0; id < devices; ++id) {
+        guarded[id] = board.load(slots[id]);
+    }
+
+    // Each writer owns a share of the devices, as an executor owns its clients.
+    std::atomic<bool> is_done{false};
+    std::vector<std::thread> writer_threads;
+    for (std::size_t writer = 0; writer < writers; ++writer) {
+        writer_threads.emplace_back([&, writer] {
+            std::uint64_t notifications = 0;
+            while (!is_done.load(std::memory_order_relaxed)) {
+                ++notifications;
+                for (auto id = writer; id < devices; id += writers) {
+                    DeviceSnapshot snapshot;
+                    snapshot.device        = id;
+                    snapshot.notifications = notifications;
+                    snapshot.is_present    = true;
+                    snapshot.pin_state.set(static_cast<std::uint8_t>(notifications % 8), PinState::Status::On);
+                    board.store(slots[id], snapshot);
+                    std::lock_guard lock_guard(mutex);
+                    guarded[id] = snapshot;
+                }
+            }
+        });
+    }
+
+    BENCHMARK("status board, powered outlets of 10k devices")
+    {
+        std::size_t powered = 0;
+        board.for_each([&](const DeviceSnapshot& snapshot) { powered += snapshot.pin_state.on.count(); });
+        return powered;
+    };
+
+    BENCHMARK("status board, one device")
+    {
+        return board.load(slots[devices / 2]).notifications;
+    };
+
+    BENCHMARK("mutex-guarded map, powered outlets of 10k devices")
+    {
+        std::size_t powered = 0;
+        std::lock_guard lock_guard(mutex);
+        for (const auto& pair : guarded) {
+            powered += pair.second.pin_state.on.count();
+        }
+        return powered;
+    };
+
+    BENCHMARK("mutex-guarded map, one device")
+    {
+        std::lock_guard lock_guard(mutex);
+        return guarded.at(devices / 2).notifications;
+    };
+
+    is_done = true;
+    for (auto& thread : writer_threads) {
+        thread.join();
+    }
+}
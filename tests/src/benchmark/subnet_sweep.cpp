@@ -0,0 +1,65 @@
+#include "catch2/catch.hpp"
+
+#include "client_finder/client_finder.hpp"
+#include "fixture/fake_site.hpp"
+#include "fixture/test_utils.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+// Unicast discovery of a /16 answered by a local stand-in for the site: how long the sweep takes at a given rate,
+// and how many KnockKnocks or answers are lost on the way.
+TEST_CASE("Subnet sweep: a /16 at several rates", "[.][benchmark]")
+{
+    using namespace tsvetkov;
+    test::register_endian_conversion();
+
+    constexpr std::uint64_t hosts = 65534;
+
+    // probes per second, zero for no limit
+    for (double rate : {20000.0, 50000.0, 0.0}) {
+        test::FakeSite site;
+
+        asio::io_context io;
+        asio::executor_work_guard<asio::io_context::executor_type> work_guard(io.get_executor());
+        auto asio_worker = std::thread([&] { io.run(); });
+
+        ClientFinderOptions options;
+        options.broadcast_port         = site.port();
+        options.listen_port            = 0;
+        options.sweep_ranges           = {"127.1.0.0/16"};
+        options.sweep_rate             = rate;
+        options.probe_initial_interval = std::chrono::hours(1);
+        auto finder                    = std::make_shared<ClientFinder>(io, options);
+        std::atomic<std::uint64_t> found{0};
+        finder->subscribe_to_found_new_device_event([&](FoundDevice) { ++found; });
+
+        auto start = std::chrono::steady_clock::now();
+        finder->start();
+        REQUIRE(test::wait_until(
+            [&] {
+                auto stats = finder->stats();
+                return stats.knocks_sent + stats.knocks_failed == hosts;
+            },
+            std::chrono::seconds(60)));
+        auto swept = std::chrono::steady_clock::now() - start;
+        // late answers
+        test::wait_until([&] { return found == site.answers(); }, std::chrono::seconds(2));
+        auto discovered = std::chrono::steady_clock::now() - start;
+
+        auto stats = finder->stats();
+        WARN("rate " << rate << "/s: swept " << hosts << " hosts in "
+                     << std::chrono::duration_cast<std::chrono::milliseconds>(swept).count() << " ms, all answers in "
+                     << std::chrono::duration_cast<std::chrono::milliseconds>(discovered).count()
+                     << " ms; KnockKnocks failed " << stats.knocks_failed << ", lost "
+                     << stats.knocks_sent - site.knocks() << ", answers lost " << site.answers() - found
+                     << ", devices found " << found);
+
+        finder->stop();
+        finder.reset();
+        work_guard.reset();
+        io.stop();
+        asio_worker.join();
+    }
+}
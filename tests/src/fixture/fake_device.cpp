@@ -0,0 +1,247 @@
+#include "fake_device.hpp"
+
+#include "common/ring_buffer.hpp"
+#include "protocol/command_handler.hpp"
+#include "protocol/protocol.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <string>
+#include <unordered_map>
+
+namespace tsvetkov {
+namespace test {
+struct FakeDevice::Session : std::enable_shared_from_this<Session>
+{
+    Session(FakeDevice& device, asio::ip::tcp::socket socket, std::uint32_t device_id)
+        : device(device), socket(std::move(socket)), device_id(device_id)
+    {
+        for (std::uint8_t pin = 0; pin < device.pins_; ++pin) {
+            status.emplace(pin, protocol::SmartPowerStatus::Status::Off);
+        }
+        handler.subscribe([this](std::uint32_t id, protocol::HelloRequest) {
+            if (this->device.handshake_muted_.load(std::memory_order_relaxed)) {
+                return;
+            }
+            protocol::HelloResponse hello_response;
+            hello_response.type_device    = protocol::DeviceType::SmartPowerStrip;
+            hello_response.high_device_id = 0;
+            hello_response.low_device_id  = this->device_id;
+            send(protocol::make_hello_response(id, hello_response));
+            notify();
+        });
+        // not a command: neither counted nor muted by set_muted()
+        handler.subscribe([this](std::uint32_t id, protocol::PingCommand) {
+            if (!this->device.pings_muted_.load(std::memory_order_relaxed)) {
+                send(protocol::make_ok_response(id));
+            }
+        });
+        handler.subscribe([this](std::uint32_t id, protocol::AllOnCommand) {
+            set_all(protocol::SmartPowerStatus::Status::On);
+            acknowledge(id);
+        });
+        handler.subscribe([this](std::uint32_t id, protocol::AllOffCommand) {
+            set_all(protocol::SmartPowerStatus::Status::Off);
+            acknowledge(id);
+        });
+        handler.subscribe([this](std::uint32_t id, protocol::Inversion inversion) {
+            auto it = status.find(inversion.port);
+            if (it != status.end()) {
+                it->second = it->second == protocol::SmartPowerStatus::Status::On
+                                 ? protocol::SmartPowerStatus::Status::Off
+                                 : protocol::SmartPowerStatus::Status::On;
+            }
+            acknowledge(id);
+        });
+    }
+
+    void start()
+    {
+        read();
+    }
+
+    void read()
+    {
+        socket.async_read_some(incoming.prepare(),
+                               [self = shared_from_this()](const std::error_code& ec, std::size_t bytes_transferred) {
+                                   if (ec) {
+                                       return;
+                                   }
+                                   self->incoming.commit(bytes_transferred);
+                                   while (self->incoming.size() >= protocol::Message::packet_size) {
+                                       auto size_packet = protocol::expected_packet_size(
+                                           self->incoming.peek(protocol::Message::packet_size));
+                                       if (size_packet < protocol::Message::packet_size ||
+                                           size_packet > decltype(self->incoming)::capacity) {
+                                           self->close();
+                                           return;
+                                       }
+                                       if (size_packet > self->incoming.size()) {
+                                           break;
+                                       }
+                                       self->handler.parse(self->incoming.peek(size_packet), size_packet);
+                                       self->incoming.consume(size_packet);
+                                   }
+                                   self->read();
+                               });
+    }
+
+    template<typename Buffer>
+    void send(const Buffer& buffer)
+    {
+        output.emplace_back(buffer.begin(), buffer.end());
+        write();
+    }
+
+    void write()
+    {
+        if (is_writing || output.empty()) {
+            return;
+        }
+        is_writing = true;
+        writing.swap(output);
+        buffers.clear();
+        for (const auto& packet : writing) {
+            buffers.emplace_back(asio::buffer(packet));
+        }
+        asio::async_write(socket, buffers, [self = shared_from_this()](const std::error_code& ec, std::size_t) {
+            self->writing.clear();
+            self->is_writing = false;
+            if (!ec) {
+                self->write();
+            }
+        });
+    }
+
+    void acknowledge(std::uint32_t id)
+    {
+        device.commands_.fetch_add(1, std::memory_order_relaxed);
+        if (device.muted_.load(std::memory_order_relaxed)) {
+            return;
+        }
+        send(protocol::make_ok_response(id));
+        if (device.notify_on_change_) {
+            notify();
+        }
+    }
+
+    void notify()
+    {
+        protocol::Error error = protocol::Error::NoError;
+        auto notification     = protocol::make_smart_power_notification(error, status);
+        send(std::string(notification.data(), protocol::expected_packet_size(notification.data())));
+    }
+
+    void set_all(protocol::SmartPowerStatus::Status value)
+    {
+        for (auto& pair : status) {
+            pair.second = value;
+        }
+    }
+
+    void close()
+    {
+        std::error_code ec;
+        socket.close(ec);
+    }
+
+    FakeDevice& device;
+    asio::ip::tcp::socket socket;
+    std::uint32_t device_id;
+    RingBuffer<4096> incoming;
+    protocol::CommandHandler handler;
+    std::unordered_map<std::uint8_t, protocol::SmartPowerStatus::Status> status;
+
+    bool is_writing = false;
+    std::deque<std::string> output;
+    std::deque<std::string> writing;
+    std::vector<asio::const_buffer> buffers;
+};
+
+FakeDevice::FakeDevice(std::uint8_t pins, bool notify_on_change, std::size_t threads)
+    : pins_(pins),
+      notify_on_change_(notify_on_change),
+      work_guard_(io_.get_executor()),
+      acceptor_(io_, asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), 0))
+{
+    acceptor_.listen(asio::socket_base::max_listen_connections);
+    accept();
+    for (std::size_t i = 0; i < std::max<std::size_t>(threads, 1); ++i) {
+        threads_.emplace_back([this] { io_.run(); });
+    }
+}
+
+FakeDevice::~FakeDevice()
+{
+    work_guard_.reset();
+    io_.stop();
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+std::uint16_t FakeDevice::port() const
+{
+    return acceptor_.local_endpoint().port();
+}
+
+std::size_t FakeDevice::sessions() const
+{
+    std::lock_guard lock_guard(sessions_mutex_);
+    return static_cast<std::size_t>(std::count_if(
+        sessions_.begin(), sessions_.end(), [](const std::weak_ptr<Session>& session) { return !session.expired(); }));
+}
+
+std::uint64_t FakeDevice::commands() const
+{
+    return commands_.load(std::memory_order_relaxed);
+}
+
+void FakeDevice::set_muted(bool muted)
+{
+    muted_.store(muted, std::memory_order_relaxed);
+}
+
+void FakeDevice::set_handshake_muted(bool muted)
+{
+    handshake_muted_.store(muted, std::memory_order_relaxed);
+}
+
+void FakeDevice::set_pings_muted(bool muted)
+{
+    pings_muted_.store(muted, std::memory_order_relaxed);
+}
+
+void FakeDevice::drop_all()
+{
+    std::lock_guard lock_guard(sessions_mutex_);
+    for (auto& weak_session : sessions_) {
+        if (auto session = weak_session.lock()) {
+            asio::post(session->socket.get_executor(), [session] { session->close(); });
+        }
+    }
+    sessions_.clear();
+}
+
+void FakeDevice::accept()
+{
+    acceptor_.async_accept(asio::make_strand(io_), [this](const std::error_code& ec, asio::ip::tcp::socket socket) {
+        if (ec) {
+            return;
+        }
+        socket.set_option(asio::ip::tcp::no_delay(true));
+        auto session = std::make_shared<Session>(*this, std::move(socket), next_device_id_++);
+        {
+            std::lock_guard lock_guard(sessions_mutex_);
+            sessions_.erase(std::remove_if(sessions_.begin(),
+                                           sessions_.end(),
+                                           [](const std::weak_ptr<Session>& s) { return s.expired(); }),
+                            sessions_.end());
+            sessions_.push_back(session);
+        }
+        session->start();
+        accept();
+    });
+}
+} // namespace test
+} // namespace tsvetkov
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "asio.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace tsvetkov {
+namespace test {
+// Local stand-in for a fleet of smart power strips: a TCP server on 127.0.0.1 that answers the hello handshake with
+// a HelloResponse and a status notification, and acknowledges pings and all on / all off / inversion with an
+// OkResponse.
+// Every accepted connection behaves as its own strip. Runs on its own threads, one strand per connection.
+class FakeDevice
+{
+public:
+    explicit FakeDevice(std::uint8_t pins = 8, bool notify_on_change = false, std::size_t threads = 1);
+    ~FakeDevice();
+
+    FakeDevice(const FakeDevice&) = delete;
+    FakeDevice& operator=(const FakeDevice&) = delete;
+
+    std::uint16_t port() const;
+
+    std::size_t sessions() const;
+    std::uint64_t commands() const;
+
+    // Closes every open connection, as a site power blip would.
+    void drop_all();
+
+    // While muted, commands are still applied and counted but never acknowledged.
+    void set_muted(bool muted);
+    // While the handshake is muted, hello requests are read but never answered.
+    void set_handshake_muted(bool muted);
+    // While pings are muted, they are read but never answered; set_muted() leaves pings alone.
+    void set_pings_muted(bool muted);
+
+private:
+    struct Session;
+
+    void accept();
+
+    std::uint8_t pins_;
+    bool notify_on_change_;
+
+    asio::io_context io_;
+    asio::executor_work_guard<asio::io_context::executor_type> work_guard_;
+    asio::ip::tcp::acceptor acceptor_;
+
+    mutable std::mutex sessions_mutex_;
+    std::vector<std::weak_ptr<Session>> sessions_;
+    std::atomic<std::uint64_t> commands_{0};
+    std::atomic<bool> muted_{false};
+    std::atomic<bool> handshake_muted_{false};
+    std::atomic<bool> pings_muted_{false};
+    std::atomic<std::uint32_t> next_device_id_{0};
+
+    std::vector<std::thread> threads_;
+};
+} // namespace test
+} // namespace tsvetkov
@@ -0,0 +1,61 @@
+#include "fake_site.hpp"
+
+#include "protocol/protocol.hpp"
+
+namespace tsvetkov {
+namespace test {
+FakeSite::FakeSite(std::uint64_t lost_knocks)
+    : socket_(io_, asio::ip::udp::endpoint(asio::ip::udp::v4(), 0)), lost_knocks_(lost_knocks)
+{
+    socket_.set_option(asio::socket_base::receive_buffer_size(4 * 1024 * 1024));
+    socket_.set_option(asio::socket_base::send_buffer_size(4 * 1024 * 1024));
+    receive();
+    thread_ = std::thread([this] { io_.run(); });
+}
+
+FakeSite::~FakeSite()
+{
+    io_.stop();
+    thread_.join();
+}
+
+std::uint16_t FakeSite::port() const
+{
+    return socket_.local_endpoint().port();
+}
+
+std::uint64_t FakeSite::knocks() const
+{
+    return knocks_.load(std::memory_order_relaxed);
+}
+
+std::uint64_t FakeSite::answers() const
+{
+    return answers_.load(std::memory_order_relaxed);
+}
+
+void FakeSite::receive()
+{
+    socket_.async_receive_from(
+        asio::buffer(datagram_), sender_, [this](const std::error_code& ec, std::size_t bytes_transferred) {
+            if (ec) {
+                return;
+            }
+            if (bytes_transferred == protocol::KnockKnock::packet_size &&
+                knocks_.fetch_add(1, std::memory_order_relaxed) >= lost_knocks_) {
+                protocol::HelloResponse hello_response;
+                hello_response.type_device    = protocol::DeviceType::SmartPowerStrip;
+                hello_response.high_device_id = 2;
+                hello_response.low_device_id  = next_device_id_++;
+                auto datagram                 = protocol::make_hello_response(0, hello_response);
+                std::error_code send_ec;
+                socket_.send_to(asio::buffer(datagram.data(), datagram.size()), sender_, 0, send_ec);
+                if (!send_ec) {
+                    answers_.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+            receive();
+        });
+}
+} // namespace test
+} // namespace tsvetkov
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "asio.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+namespace tsvetkov {
+namespace test {
+// Local stand-in for the strips of a site as discovery sees them: one UDP socket bound to INADDR_ANY, so it receives
+// the KnockKnocks sent to any host of 127.0.0.0/8, and answers each with a HelloResponse of a new device. A unicast
+// sweep of a range thus finds one device per host, but every answer comes from 127.0.0.1: the devices differ by id,
+// not by address. Runs on its own thread.
+class FakeSite
+{
+public:
+    // The first `lost_knocks` KnockKnocks go unanswered, as if lost on the way.
+    explicit FakeSite(std::uint64_t lost_knocks = 0);
+    ~FakeSite();
+
+    FakeSite(const FakeSite&) = delete;
+    FakeSite& operator=(const FakeSite&) = delete;
+
+    std::uint16_t port() const;
+
+    std::uint64_t knocks() const;
+    std::uint64_t answers() const;
+
+private:
+    void receive();
+
+    asio::io_context io_;
+    asio::ip::udp::socket socket_;
+    asio::ip::udp::endpoint sender_;
+    std::array<char, 512> datagram_;
+    std::uint64_t lost_knocks_;
+    std::uint32_t next_device_id_ = 0;
+
+    std::atomic<std::uint64_t> knocks_{0};
+    std::atomic<std::uint64_t> answers_{0};
+
+    std::thread thread_;
+};
+} // namespace test
+} // namespace tsvetkov
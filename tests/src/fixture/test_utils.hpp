@@ -0,0 +1,47 @@
+#pragma once
+
+#include "boost/endian/conversion.hpp"
+
+#include "protocol/protocol.hpp"
+
+#include <sys/resource.h>
+
+#include <chrono>
+#include <thread>
+
+namespace tsvetkov {
+namespace test {
+inline void register_endian_conversion()
+{
+    protocol::register_big_endian_to_native(&boost::endian::big_to_native);
+    protocol::register_native_to_big_endian(&boost::endian::native_to_big);
+}
+
+// Raises the soft limit of open descriptors up to the hard limit, returns false if `required` is still out of reach.
+inline bool raise_open_files_limit(std::size_t required)
+{
+    rlimit limit{};
+    if (getrlimit(RLIMIT_NOFILE, &limit) != 0) {
+        return false;
+    }
+    if (limit.rlim_cur >= required) {
+        return true;
+    }
+    limit.rlim_cur = std::min<rlim_t>(limit.rlim_max, required);
+    return setrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur >= required;
+}
+
+template<typename Predicate>
+bool wait_until(Predicate predicate, std::chrono::steady_clock::duration timeout)
+{
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!predicate()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return true;
+}
+} // namespace test
+} // namespace tsvetkov
@@ -0,0 +1,95 @@
+#include "catch2/catch.hpp"
+
+#include "common/admission_limiter.hpp"
+
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+using tsvetkov::AdmissionLimiter;
+
+TEST_CASE("Admission limiter: concurrency cap and FIFO order", "[admission_limiter]")
+{
+    asio::io_context io;
+    // no rate limit: only the cap holds waiters back
+    auto limiter = AdmissionLimiter::create(io, AdmissionLimiter::Options{2, 0.0, 1.0});
+
+    std::vector<int> granted;
+    std::vector<AdmissionLimiter::Permit> permits;
+    permits.reserve(5);
+    for (int i = 0; i < 5; ++i) {
+        limiter->acquire([&granted, &permits, i](AdmissionLimiter::Permit permit) {
+            granted.push_back(i);
+            permits.push_back(std::move(permit));
+        });
+    }
+    REQUIRE(granted == std::vector<int>{0, 1});
+    REQUIRE(limiter->in_flight() == 2);
+    REQUIRE(limiter->waiting() == 3);
+
+    permits[1].release();
+    REQUIRE(granted == std::vector<int>{0, 1, 2});
+    REQUIRE(limiter->in_flight() == 2);
+
+    // a moved-from permit gives nothing back, its new owner does
+    auto moved = std::move(permits[0]);
+    permits[0].release();
+    REQUIRE(granted.size() == 3);
+    moved = AdmissionLimiter::Permit();
+    REQUIRE(granted == std::vector<int>{0, 1, 2, 3});
+
+    permits[2].release();
+    permits[3].release();
+    REQUIRE(granted == std::vector<int>{0, 1, 2, 3, 4});
+    REQUIRE(limiter->waiting() == 0);
+
+    permits.clear();
+    REQUIRE(limiter->in_flight() == 0);
+}
+
+TEST_CASE("Admission limiter: the refill timer grants at the token rate", "[admission_limiter]")
+{
+    asio::io_context io;
+    asio::executor_work_guard<asio::io_context::executor_type> work_guard(io.get_executor());
+    auto asio_worker = std::thread([&] { io.run(); });
+
+    // one token saved, then one every 50 ms; the cap is never reached
+    auto start   = std::chrono::steady_clock::now();
+    auto limiter = AdmissionLimiter::create(io, AdmissionLimiter::Options{16, 20.0, 1.0});
+
+    std::mutex mutex;
+    std::vector<std::chrono::steady_clock::time_point> granted_at;
+    std::vector<AdmissionLimiter::Permit> permits;
+    for (int i = 0; i < 4; ++i) {
+        limiter->acquire([&](AdmissionLimiter::Permit permit) {
+            std::lock_guard lock_guard(mutex);
+            granted_at.push_back(std::chrono::steady_clock::now());
+            permits.push_back(std::move(permit));
+        });
+    }
+    {
+        std::lock_guard lock_guard(mutex);
+        REQUIRE(granted_at.size() == 1);
+    }
+
+    auto deadline = start + 5s;
+    while (limiter->waiting() != 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(5ms);
+    }
+    {
+        std::lock_guard lock_guard(mutex);
+        REQUIRE(granted_at.size() == 4);
+        // the timer never fires before the token is there
+        for (std::size_t i = 1; i < granted_at.size(); ++i) {
+            REQUIRE(granted_at[i] - start >= 50ms * static_cast<int>(i) - 1ms);
+        }
+        permits.clear();
+    }
+    REQUIRE(limiter->in_flight() == 0);
+
+    work_guard.reset();
+    io.stop();
+    asio_worker.join();
+}
@@ -0,0 +1,87 @@
+#include "catch2/catch.hpp"
+
+#include "common/bounded_mpmc_queue.hpp"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+TEST_CASE("Bounded MPMC queue: single thread", "[bounded_mpmc_queue]")
+{
+    tsvetkov::BoundedMpmcQueue<int> queue(3);
+    REQUIRE(queue.capacity() == 4);
+    REQUIRE(queue.pop() == nullptr);
+
+    int elements[5] = {0, 1, 2, 3, 4};
+    for (int i = 0; i < 4; ++i) {
+        REQUIRE(queue.push(&elements[i]));
+    }
+    REQUIRE_FALSE(queue.push(&elements[4]));
+
+    REQUIRE(queue.pop() == &elements[0]);
+    REQUIRE(queue.push(&elements[4]));
+    for (int i = 1; i < 5; ++i) {
+        REQUIRE(queue.pop() == &elements[i]);
+    }
+    REQUIRE(queue.pop() == nullptr);
+}
+
+TEST_CASE("Bounded MPMC queue: every element is taken exactly once", "[bounded_mpmc_queue]")
+{
+    constexpr std::size_t elements = 64;
+    constexpr std::size_t takers   = 8;
+    constexpr std::size_t rounds   = 20000;
+
+    // One thread gives the elements back, the others take them: the Client's command pool.
+    tsvetkov::BoundedMpmcQueue<std::size_t> queue(elements);
+    std::vector<std::size_t> storage(elements);
+    std::vector<std::atomic<int>> owners(elements);
+    for (std::size_t i = 0; i < elements; ++i) {
+        storage[i] = i;
+        REQUIRE(queue.push(&storage[i]));
+    }
+
+    tsvetkov::BoundedMpmcQueue<std::size_t> returned(elements);
+    std::atomic<bool> is_duplicate{false};
+    std::vector<std::thread> threads;
+    for (std::size_t taker = 0; taker < takers; ++taker) {
+        threads.emplace_back([&] {
+            for (std::size_t round = 0; round < rounds;) {
+                auto element = queue.pop();
+                if (!element) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                if (owners[*element].fetch_add(1) != 0) {
+                    is_duplicate = true;
+                }
+                owners[*element].fetch_sub(1);
+                while (!returned.push(element)) {
+                    std::this_thread::yield();
+                }
+                ++round;
+            }
+        });
+    }
+
+    std::size_t given_back = 0;
+    while (given_back < takers * rounds) {
+        auto element = returned.pop();
+        if (!element) {
+            std::this_thread::yield();
+            continue;
+        }
+        REQUIRE(queue.push(element));
+        ++given_back;
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    REQUIRE_FALSE(is_duplicate);
+    std::size_t left = 0;
+    while (queue.pop()) {
+        ++left;
+    }
+    REQUIRE(left == elements);
+}
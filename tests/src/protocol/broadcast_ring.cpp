@@ -0,0 +1,149 @@
+#include "catch2/catch.hpp"
+
+#include "client/status_stream.hpp"
+#include "common/broadcast_ring.hpp"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace {
+// Every field derived from `value`, so a torn read shows.
+struct Element
+{
+    std::uint64_t producer = 0;
+    std::uint64_t value    = 0;
+    std::uint64_t check    = 0;
+};
+
+Element make_element(std::uint64_t producer, std::uint64_t value)
+{
+    return Element{producer, value, producer * 1000003 ^ value};
+}
+} // namespace
+
+TEST_CASE("Broadcast ring: every reader sees every element", "[broadcast_ring]")
+{
+    tsvetkov::BroadcastRing<Element> ring(8);
+    auto early = ring.subscribe();
+    ring.publish(make_element(0, 1));
+    auto late = ring.subscribe();
+    ring.publish(make_element(0, 2));
+
+    REQUIRE(early.dropped() == 0);
+    REQUIRE(ring.poll(early)->value == 1);
+    REQUIRE(ring.poll(early)->value == 2);
+    REQUIRE_FALSE(ring.poll(early));
+    REQUIRE(ring.poll(late)->value == 2);
+    REQUIRE_FALSE(ring.poll(late));
+}
+
+TEST_CASE("Broadcast ring: a lapped reader skips ahead", "[broadcast_ring]")
+{
+    tsvetkov::BroadcastRing<Element> ring(8);
+    auto reader = ring.subscribe();
+    for (std::uint64_t i = 0; i < 20; ++i) {
+        ring.publish(make_element(0, i));
+    }
+    std::vector<std::uint64_t> values;
+    ring.drain(reader, [&](const Element& element) { values.push_back(element.value); });
+    REQUIRE(reader.dropped() == 16);
+    REQUIRE(values == std::vector<std::uint64_t>{16, 17, 18, 19});
+}
+
+TEST_CASE("Broadcast ring: concurrent producers and readers", "[broadcast_ring]")
+{
+    constexpr std::uint64_t producers = 4;
+    constexpr std::uint64_t per_producer = 50000;
+    tsvetkov::BroadcastRing<Element> ring(1024);
+
+    std::atomic<bool> is_done{false};
+    std::atomic<std::uint64_t> torn{0};
+    std::atomic<std::uint64_t> reordered{0};
+    std::vector<std::uint64_t> received(2, 0);
+    std::vector<std::uint64_t> dropped(2, 0);
+    std::vector<std::thread> readers;
+    for (std::size_t r = 0; r < 2; ++r) {
+        readers.emplace_back([&, r, cursor = ring.subscribe()]() mutable {
+            std::vector<std::uint64_t> last(producers, 0);
+            auto consume = [&](const Element& element) {
+                if (element.check != (element.producer * 1000003 ^ element.value) || element.producer >= producers) {
+                    ++torn;
+                    return;
+                }
+                // one producer's elements arrive in order, possibly with gaps
+                if (element.value <= last[element.producer]) {
+                    ++reordered;
+                }
+                last[element.producer] = element.value;
+                ++received[r];
+            };
+            while (!is_done.load()) {
+                if (ring.drain(cursor, consume, 64) == 0) {
+                    std::this_thread::yield();
+                }
+                // the second reader is slow and gets lapped
+                if (r == 1) {
+                    std::this_thread::sleep_for(std::chrono::microseconds(50));
+                }
+            }
+            ring.drain(cursor, consume);
+            dropped[r] = cursor.dropped();
+        });
+    }
+
+    std::vector<std::thread> writers;
+    for (std::uint64_t p = 0; p < producers; ++p) {
+        writers.emplace_back([&, p] {
+            for (std::uint64_t i = 1; i <= per_producer; ++i) {
+                ring.publish(make_element(p, i));
+            }
+        });
+    }
+    for (auto& writer : writers) {
+        writer.join();
+    }
+    is_done = true;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+
+    REQUIRE(torn == 0);
+    REQUIRE(reordered == 0);
+    REQUIRE(ring.published() == producers * per_producer);
+    for (std::size_t r = 0; r < 2; ++r) {
+        REQUIRE(received[r] + dropped[r] == producers * per_producer);
+    }
+}
+
+TEST_CASE("Status stream: only changed pins are published", "[broadcast_ring]")
+{
+    using tsvetkov::PinLevel;
+    using Status = tsvetkov::PinState::Status;
+
+    tsvetkov::StatusStream stream(64);
+    auto subscription = stream.subscribe();
+
+    tsvetkov::PinState before;
+    before.set(0, Status::Off);
+    before.set(1, Status::On);
+    auto after = before;
+    after.set(1, Status::Off);
+    after.set(2, Status::On);
+
+    REQUIRE(stream.publish(7, before, before) == 0);
+    REQUIRE(stream.publish(7, before, after) == 2);
+
+    auto first = subscription.poll();
+    REQUIRE(first);
+    REQUIRE(first->device == 7);
+    REQUIRE(first->pin == 1);
+    REQUIRE(first->old_level == PinLevel::On);
+    REQUIRE(first->new_level == PinLevel::Off);
+    auto second = subscription.poll();
+    REQUIRE(second);
+    REQUIRE(second->pin == 2);
+    REQUIRE(second->old_level == PinLevel::Absent);
+    REQUIRE(second->new_level == PinLevel::On);
+    REQUIRE_FALSE(subscription.poll());
+}
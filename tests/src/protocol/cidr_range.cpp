@@ -0,0 +1,35 @@
+#include "catch2/catch.hpp"
+
+#include "client_finder/cidr_range.hpp"
+
+TEST_CASE("CIDR range: hosts of a block", "[cidr_range]")
+{
+    using namespace tsvetkov;
+
+    auto range = parse_cidr_range("10.20.30.40/16");
+    REQUIRE(range);
+    REQUIRE(range->network.to_string() == "10.20.0.0");
+    REQUIRE(range->prefix_length == 16);
+    REQUIRE(range->host_count() == 65534);
+    REQUIRE(range->host(0).to_string() == "10.20.0.1");
+    REQUIRE(range->host(range->host_count() - 1).to_string() == "10.20.255.254");
+
+    // no network or broadcast address to skip
+    REQUIRE(parse_cidr_range("192.168.1.7")->host_count() == 1);
+    REQUIRE(parse_cidr_range("192.168.1.7")->host(0).to_string() == "192.168.1.7");
+    REQUIRE(parse_cidr_range("192.168.1.6/31")->host_count() == 2);
+    REQUIRE(parse_cidr_range("192.168.1.6/31")->host(1).to_string() == "192.168.1.7");
+    REQUIRE(parse_cidr_range("0.0.0.0/0")->host_count() == 4294967294u);
+}
+
+TEST_CASE("CIDR range: malformed input", "[cidr_range]")
+{
+    using namespace tsvetkov;
+
+    REQUIRE_FALSE(parse_cidr_range(""));
+    REQUIRE_FALSE(parse_cidr_range("10.20.0.0/"));
+    REQUIRE_FALSE(parse_cidr_range("10.20.0.0/33"));
+    REQUIRE_FALSE(parse_cidr_range("10.20.0.0/1a"));
+    REQUIRE_FALSE(parse_cidr_range("10.20.0/16"));
+    REQUIRE_FALSE(parse_cidr_range("site/16"));
+}
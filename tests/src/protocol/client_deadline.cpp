@@ -0,0 +1,76 @@
+#include "catch2/catch.hpp"
+
+#include "client/client.hpp"
+#include "fixture/fake_device.hpp"
+#include "fixture/test_utils.hpp"
+
+#include <chrono>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+namespace {
+std::error_code command_error(pc::future<tsvetkov::Client::command_result_type> future)
+{
+    try {
+        future.get();
+    } catch (const std::system_error& e) {
+        return e.code();
+    }
+    return {};
+}
+} // namespace
+
+TEST_CASE("Client: command deadlines", "[client]")
+{
+    using namespace tsvetkov;
+    test::register_endian_conversion();
+
+    test::FakeDevice device;
+
+    asio::io_context io;
+    asio::executor_work_guard<asio::io_context::executor_type> work_guard(io.get_executor());
+    auto asio_worker = std::thread([&] { io.run(); });
+
+    ClientOptions options;
+    options.request_timeout = 100ms;
+    auto client             = std::make_shared<Client>(io, "127.0.0.1", device.port(), options);
+    client->connect();
+
+    SECTION("an unanswered command times out")
+    {
+        device.set_muted(true);
+        REQUIRE(command_error(client->async_send_all_on()) == std::errc::timed_out);
+
+        device.set_muted(false);
+        REQUIRE(command_error(client->async_send_all_off()) == std::error_code{});
+    }
+
+    SECTION("in-flight commands fail when the connection drops")
+    {
+        device.set_muted(true);
+        auto first  = client->async_inversion(1, 10s);
+        auto second = client->async_inversion(2, 10s);
+        REQUIRE(test::wait_until([&] { return device.commands() == 2; }, 5s));
+
+        device.drop_all();
+        REQUIRE(command_error(std::move(first)) == std::errc::connection_aborted);
+        REQUIRE(command_error(std::move(second)) == std::errc::connection_aborted);
+    }
+
+    SECTION("commands queued while disconnected fail when the client reconnects")
+    {
+        device.drop_all();
+        REQUIRE(test::wait_until([&] { return client->connection_state() != ConnectionState::Connected; }, 5s));
+        // no deadline: only the reconnect can resolve it
+        auto queued = client->async_inversion(1, 0s);
+        REQUIRE(test::wait_until([&] { return queued.is_ready(); }, 5s));
+        REQUIRE(command_error(std::move(queued)) == std::errc::connection_aborted);
+        REQUIRE(test::wait_until([&] { return client->connection_state() == ConnectionState::Connected; }, 5s));
+    }
+
+    client.reset();
+    work_guard.reset();
+    io.stop();
+    asio_worker.join();
+}
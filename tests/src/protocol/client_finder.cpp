@@ -0,0 +1,210 @@
+#include "catch2/catch.hpp"
+
+#include "client_finder/client_finder.hpp"
+#include "fixture/fake_site.hpp"
+#include "fixture/test_utils.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+TEST_CASE("Client finder: a whole site answering at once", "[client_finder]")
+{
+    using namespace tsvetkov;
+    test::register_endian_conversion();
+
+    constexpr std::uint32_t devices = 10000;
+
+    asio::io_context io;
+    asio::executor_work_guard<asio::io_context::executor_type> work_guard(io.get_executor());
+    auto asio_worker = std::thread([&] { io.run(); });
+
+    // the KnockKnock goes here, unicast so that nothing leaves the host, and is ignored
+    asio::ip::udp::socket knock_sink(io, asio::ip::udp::endpoint(asio::ip::udp::v4(), 0));
+
+    ClientFinderOptions options;
+    options.broadcast_port = knock_sink.local_endpoint().port();
+    options.listen_port    = 0;
+    options.sweep_ranges   = {"127.0.0.1"};
+    auto finder            = std::make_shared<ClientFinder>(io, options);
+    std::atomic<std::uint32_t> found{0};
+    finder->subscribe_to_found_new_device_event([&](FoundDevice) { ++found; });
+
+    // Stand-in for the strips of a site: every answer sent back to back, all of them queued before the finder reads.
+    asio::ip::udp::socket site(io, asio::ip::udp::endpoint(asio::ip::udp::v4(), 0));
+    asio::ip::udp::endpoint finder_endpoint(asio::ip::address_v4::loopback(), finder->listen_port());
+    for (std::uint32_t id = 0; id < devices; ++id) {
+        protocol::HelloResponse hello_response;
+        hello_response.type_device    = protocol::DeviceType::SmartPowerStrip;
+        hello_response.high_device_id = 1;
+        hello_response.low_device_id  = id;
+        auto datagram                 = protocol::make_hello_response(id, hello_response);
+        site.send_to(asio::buffer(datagram.data(), datagram.size()), finder_endpoint);
+    }
+    finder->start();
+
+    if (finder->receive_buffer_size() >= options.receive_buffer_size) {
+        REQUIRE(test::wait_until([&] { return found == devices; }, 5s));
+    } else {
+        WARN("net.core.rmem_max limits the receive buffer to " << finder->receive_buffer_size()
+                                                               << " bytes, answers beyond it are lost");
+        std::this_thread::sleep_for(500ms);
+    }
+    auto stats = finder->stats();
+    REQUIRE(found == stats.datagrams_received);
+    REQUIRE(stats.parse_errors == 0);
+    REQUIRE(stats.datagrams_truncated == 0);
+    // full batches but the last
+    REQUIRE(stats.receive_batches == (stats.datagrams_received + options.receive_batch - 1) / options.receive_batch);
+
+    finder->stop();
+    finder.reset();
+    work_guard.reset();
+    io.stop();
+    asio_worker.join();
+}
+
+TEST_CASE("Client finder: a device answering from a new address is reported as moved", "[client_finder]")
+{
+    using namespace tsvetkov;
+    test::register_endian_conversion();
+
+    asio::io_context io;
+    asio::executor_work_guard<asio::io_context::executor_type> work_guard(io.get_executor());
+    auto asio_worker = std::thread([&] { io.run(); });
+
+    // unicast to loopback: nothing leaves the host
+    asio::ip::udp::socket knock_sink(io, asio::ip::udp::endpoint(asio::ip::udp::v4(), 0));
+    ClientFinderOptions options;
+    options.broadcast_port = knock_sink.local_endpoint().port();
+    options.listen_port    = 0;
+    options.sweep_ranges   = {"127.0.0.1"};
+    auto finder            = std::make_shared<ClientFinder>(io, options);
+
+    std::atomic<int> found{0};
+    std::atomic<int> moved{0};
+    std::string moved_from;
+    std::string moved_to;
+    finder->subscribe_to_found_new_device_event([&](FoundDevice) { ++found; });
+    finder->subscribe_to_address_changed_event([&](FoundDevice device, std::string previous_ip_address) {
+        moved_from = std::move(previous_ip_address);
+        moved_to   = device.ip_address;
+        ++moved;
+    });
+    finder->start();
+
+    asio::ip::udp::endpoint finder_endpoint(asio::ip::address_v4::loopback(), finder->listen_port());
+    auto answer_from = [&](const char* address) {
+        asio::ip::udp::socket strip(io, asio::ip::udp::endpoint(asio::ip::make_address_v4(address), 0));
+        protocol::HelloResponse hello_response;
+        hello_response.type_device    = protocol::DeviceType::SmartPowerStrip;
+        hello_response.high_device_id = 1;
+        hello_response.low_device_id  = 2;
+        auto datagram                 = protocol::make_hello_response(0, hello_response);
+        strip.send_to(asio::buffer(datagram.data(), datagram.size()), finder_endpoint);
+    };
+
+    answer_from("127.0.0.1");
+    answer_from("127.0.0.1");
+    REQUIRE(test::wait_until([&] { return finder->stats().datagrams_received == 2; }, 1s));
+    answer_from("127.0.0.2");
+    REQUIRE(test::wait_until([&] { return moved == 1; }, 1s));
+    REQUIRE(found == 1);
+    REQUIRE(moved_from == "127.0.0.1");
+    REQUIRE(moved_to == "127.0.0.2");
+
+    finder->stop();
+    finder.reset();
+    work_guard.reset();
+    io.stop();
+    asio_worker.join();
+}
+
+TEST_CASE("Client finder: a unicast sweep finds every host of the ranges", "[client_finder]")
+{
+    using namespace tsvetkov;
+    test::register_endian_conversion();
+
+    test::FakeSite site;
+
+    asio::io_context io;
+    asio::executor_work_guard<asio::io_context::executor_type> work_guard(io.get_executor());
+    auto asio_worker = std::thread([&] { io.run(); });
+
+    ClientFinderOptions options;
+    options.broadcast_port = site.port();
+    options.listen_port    = 0;
+    options.sweep_ranges   = {"127.3.0.0/24", "127.4.0.1"};
+    // a single sweep
+    options.probe_initial_interval = std::chrono::hours(1);
+    auto finder                    = std::make_shared<ClientFinder>(io, options);
+    std::atomic<std::uint32_t> found{0};
+    finder->subscribe_to_found_new_device_event([&](FoundDevice) { ++found; });
+    finder->start();
+
+    REQUIRE(test::wait_until([&] { return found == 255; }, 5s));
+    auto stats = finder->stats();
+    REQUIRE(stats.probe_rounds == 1);
+    REQUIRE(stats.knocks_sent == 255);
+    REQUIRE(stats.knocks_failed == 0);
+    REQUIRE(site.knocks() == 255);
+
+    finder->stop();
+    finder.reset();
+    work_guard.reset();
+    io.stop();
+    asio_worker.join();
+}
+
+TEST_CASE("Client finder: nothing is sent after stop", "[client_finder]")
+{
+    using namespace tsvetkov;
+    test::register_endian_conversion();
+
+    test::FakeSite site;
+
+    asio::io_context io;
+    asio::executor_work_guard<asio::io_context::executor_type> work_guard(io.get_executor());
+    auto asio_worker = std::thread([&] { io.run(); });
+
+    // a sweep of one host every 10 ms
+    ClientFinderOptions options;
+    options.broadcast_port         = site.port();
+    options.listen_port            = 0;
+    options.sweep_ranges           = {"127.3.0.1"};
+    options.probe_initial_interval = 10ms;
+    options.probe_max_interval     = 10ms;
+    auto finder                    = std::make_shared<ClientFinder>(io, options);
+    finder->start();
+    REQUIRE(test::wait_until([&] { return finder->stats().probe_rounds >= 3; }, 5s));
+
+    finder->stop();
+    // whatever was posted before stop() has run by now
+    std::this_thread::sleep_for(50ms);
+    auto stopped = finder->stats();
+    auto knocks  = site.knocks();
+    std::this_thread::sleep_for(200ms);
+    REQUIRE(finder->stats().probe_rounds == stopped.probe_rounds);
+    REQUIRE(finder->stats().knocks_sent == stopped.knocks_sent);
+    REQUIRE(site.knocks() == knocks);
+
+    finder.reset();
+    work_guard.reset();
+    io.stop();
+    asio_worker.join();
+}
+
+TEST_CASE("Client finder: a malformed sweep range is rejected", "[client_finder]")
+{
+    using namespace tsvetkov;
+
+    asio::io_context io;
+    ClientFinderOptions options;
+    options.listen_port  = 0;
+    options.sweep_ranges = {"127.3.0.0/40"};
+    REQUIRE_THROWS_AS(ClientFinder(io, options), std::invalid_argument);
+}
@@ -0,0 +1,109 @@
+#include "catch2/catch.hpp"
+
+#include "client/client.hpp"
+#include "fixture/fake_device.hpp"
+#include "fixture/test_utils.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <system_error>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+TEST_CASE("Client: a connection lost during the handshake", "[client]")
+{
+    using namespace tsvetkov;
+    test::register_endian_conversion();
+
+    test::FakeDevice device;
+    device.set_handshake_muted(true);
+
+    asio::io_context io;
+    asio::executor_work_guard<asio::io_context::executor_type> work_guard(io.get_executor());
+    auto asio_worker = std::thread([&] { io.run(); });
+
+    // long enough that only the lost connection can end the handshake
+    ClientOptions options;
+    options.handshake_timeout       = 30s;
+    options.reconnect_initial_delay = 10ms;
+    auto client                     = std::make_shared<Client>(io, "127.0.0.1", device.port(), options);
+
+    auto connected = client->async_connect();
+    REQUIRE(test::wait_until([&] { return device.sessions() == 1; }, 5s));
+
+    SECTION("is retried until connected")
+    {
+        device.drop_all();
+        device.set_handshake_muted(false);
+        REQUIRE(test::wait_until([&] { return connected.is_ready(); }, 5s));
+        connected.get();
+        REQUIRE(client->connection_state() == ConnectionState::Connected);
+    }
+
+    SECTION("fails the pending connects when disconnected on purpose")
+    {
+        client->disconnect();
+        REQUIRE(connected.is_ready());
+        try {
+            connected.get();
+            FAIL("connected after disconnect()");
+        } catch (const std::system_error& e) {
+            REQUIRE(e.code() == std::errc::connection_aborted);
+        }
+        REQUIRE(client->connection_state() == ConnectionState::Disconnected);
+    }
+
+    client.reset();
+    work_guard.reset();
+    io.stop();
+    asio_worker.join();
+}
+
+TEST_CASE("Client: a handshake that times out gives its admission permit back", "[client]")
+{
+    using namespace tsvetkov;
+    test::register_endian_conversion();
+
+    test::FakeDevice device;
+    device.set_handshake_muted(true);
+
+    asio::io_context io;
+    asio::executor_work_guard<asio::io_context::executor_type> work_guard(io.get_executor());
+    auto asio_worker = std::thread([&] { io.run(); });
+
+    // one handshake at a time, no rate limit
+    auto limiter = AdmissionLimiter::create(io, AdmissionLimiter::Options{1, 0.0, 1.0});
+    ClientOptions options;
+    options.handshake_limiter       = limiter;
+    options.handshake_timeout       = 200ms;
+    options.reconnect_initial_delay = 10s;
+    auto client                     = std::make_shared<Client>(io, "127.0.0.1", device.port(), options);
+    client->connect();
+    REQUIRE(test::wait_until([&] { return limiter->in_flight() == 1 && device.sessions() == 1; }, 5s));
+
+    // queued behind the client's handshake, which the device never answers
+    std::atomic<bool> is_granted{false};
+    std::mutex mutex;
+    AdmissionLimiter::Permit permit;
+    limiter->acquire([&](AdmissionLimiter::Permit granted) {
+        std::lock_guard lock_guard(mutex);
+        permit     = std::move(granted);
+        is_granted = true;
+    });
+    REQUIRE_FALSE(is_granted);
+    REQUIRE(limiter->waiting() == 1);
+
+    REQUIRE(test::wait_until([&] { return is_granted.load(); }, 5s));
+    REQUIRE(client->connection_state() != ConnectionState::Connected);
+    {
+        std::lock_guard lock_guard(mutex);
+        permit.release();
+    }
+
+    client.reset();
+    work_guard.reset();
+    io.stop();
+    asio_worker.join();
+}
@@ -0,0 +1,96 @@
+#include "catch2/catch.hpp"
+
+#include "client/client.hpp"
+#include "fixture/fake_device.hpp"
+#include "fixture/test_utils.hpp"
+
+#include <chrono>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+TEST_CASE("Client: pings only on an idle link", "[client]")
+{
+    using namespace tsvetkov;
+    test::register_endian_conversion();
+
+    test::FakeDevice device;
+    device.set_pings_muted(true);
+
+    asio::io_context io;
+    asio::executor_work_guard<asio::io_context::executor_type> work_guard(io.get_executor());
+    auto asio_worker = std::thread([&] { io.run(); });
+
+    // pings go unanswered: probe at a fixed pace and never give up
+    ClientOptions options;
+    options.keepalive_idle   = 50ms;
+    options.keepalive_probes = 1000;
+    options.initial_rto      = 50ms;
+    options.min_rto          = 50ms;
+    options.max_rto          = 50ms;
+    auto client              = std::make_shared<Client>(io, "127.0.0.1", device.port(), options);
+    client->connect();
+
+    // busy: a command reply arrives in every keepalive period
+    auto busy_until = std::chrono::steady_clock::now() + 500ms;
+    while (std::chrono::steady_clock::now() < busy_until) {
+        client->send_all_on();
+        std::this_thread::sleep_for(5ms);
+    }
+    auto busy = client->stats();
+    REQUIRE(busy.pings_suppressed >= 5);
+    REQUIRE(busy.pings_sent <= 1);
+
+    // idle: every period ends with a ping
+    std::this_thread::sleep_for(300ms);
+    auto idle = client->stats();
+    REQUIRE(idle.pings_sent - busy.pings_sent >= 3);
+    REQUIRE(idle.pings_suppressed - busy.pings_suppressed <= 1);
+
+    client.reset();
+    work_guard.reset();
+    io.stop();
+    asio_worker.join();
+}
+
+TEST_CASE("Client: unanswered pings are repeated after the measured RTO", "[client]")
+{
+    using namespace tsvetkov;
+    test::register_endian_conversion();
+
+    test::FakeDevice device;
+
+    asio::io_context io;
+    asio::executor_work_guard<asio::io_context::executor_type> work_guard(io.get_executor());
+    auto asio_worker = std::thread([&] { io.run(); });
+
+    // Far above a loopback round trip, the initial RTO would allow a single repeat in the idle phase below.
+    ClientOptions options;
+    options.keepalive_idle   = 100ms;
+    options.keepalive_probes = 1000;
+    options.initial_rto      = 2s;
+    options.min_rto          = 30ms;
+    options.max_rto          = 4s;
+    auto client              = std::make_shared<Client>(io, "127.0.0.1", device.port(), options);
+    client->connect();
+
+    // answered pings: every one is a round trip sample
+    std::this_thread::sleep_for(500ms);
+    auto answered = client->stats();
+    REQUIRE(answered.rtt_samples >= 2);
+    REQUIRE(answered.srtt < answered.rto);
+    REQUIRE(answered.rto < options.initial_rto);
+
+    // unanswered pings: repeated after 1, 2, 4... measured RTOs, not after the initial one
+    device.set_pings_muted(true);
+    std::this_thread::sleep_for(700ms);
+    auto unanswered = client->stats();
+    REQUIRE(unanswered.pings_sent - answered.pings_sent >= 3);
+    REQUIRE(unanswered.rtt_samples <= answered.rtt_samples + 1);
+    REQUIRE(client->connection_state() == ConnectionState::Connected);
+
+    client.reset();
+    work_guard.reset();
+    io.stop();
+    asio_worker.join();
+}
@@ -0,0 +1,114 @@
+#include "catch2/catch.hpp"
+
+#include "client/client.hpp"
+#include "fixture/fake_device.hpp"
+#include "fixture/test_utils.hpp"
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+TEST_CASE("Client: a saturated bulk lane causes no false disconnects", "[client]")
+{
+    using namespace tsvetkov;
+    test::register_endian_conversion();
+
+    test::FakeDevice device;
+
+    asio::io_context io;
+    asio::executor_work_guard<asio::io_context::executor_type> work_guard(io.get_executor());
+    auto asio_worker = std::thread([&] { io.run(); });
+
+    // Coalesced, the flood of inversions would cancel out in pairs and never fill the lane.
+    ClientOptions options;
+    options.max_queued_frames = 1024;
+    options.request_timeout   = 30s;
+    options.coalesce_commands = false;
+    auto client               = std::make_shared<Client>(io, "127.0.0.1", device.port(), options);
+    client->connect();
+
+    std::size_t congested = 0;
+    std::size_t rejected  = 0;
+    std::vector<pc::future<Client::command_result_type>> bulk;
+    auto flood_until = std::chrono::steady_clock::now() + 2s;
+    while (std::chrono::steady_clock::now() < flood_until) {
+        // bulk producer: honours backpressure only every other round, so the lane really fills up
+        for (int i = 0; i < 2000; ++i) {
+            if (client->is_congested()) {
+                ++congested;
+                if (congested % 2) {
+                    break;
+                }
+            }
+            bulk.push_back(client->async_inversion(static_cast<std::uint8_t>(i % 8), 30s, Lane::Bulk));
+        }
+        // an interactive command keeps getting through
+        auto started = std::chrono::steady_clock::now();
+        REQUIRE_FALSE(client->async_send_all_on(5s).get());
+        REQUIRE(std::chrono::steady_clock::now() - started < 1s);
+    }
+
+    for (auto& future : bulk) {
+        try {
+            future.get();
+        } catch (const std::system_error& e) {
+            REQUIRE(e.code() == std::errc::no_buffer_space);
+            ++rejected;
+        }
+    }
+
+    auto stats = client->stats();
+    REQUIRE(congested > 0);
+    REQUIRE(stats.commands_rejected == rejected);
+    REQUIRE(stats.commands_coalesced == 0);
+    REQUIRE(stats.link_drops == 0);
+    REQUIRE(client->connection_state() == ConnectionState::Connected);
+
+    client.reset();
+    work_guard.reset();
+    io.stop();
+    asio_worker.join();
+}
+
+TEST_CASE("Client: queued inversions of one pin cancel out in pairs", "[client]")
+{
+    using namespace tsvetkov;
+    test::register_endian_conversion();
+
+    constexpr std::size_t commands = 20000;
+
+    test::FakeDevice device;
+
+    asio::io_context io;
+    asio::executor_work_guard<asio::io_context::executor_type> work_guard(io.get_executor());
+    auto asio_worker = std::thread([&] { io.run(); });
+
+    ClientOptions options;
+    options.max_queued_frames    = commands;
+    options.max_pending_requests = commands;
+    options.request_timeout      = 30s;
+    auto client                  = std::make_shared<Client>(io, "127.0.0.1", device.port(), options);
+    client->connect();
+
+    std::vector<pc::future<Client::command_result_type>> results;
+    results.reserve(commands);
+    for (std::size_t i = 0; i < commands; ++i) {
+        results.push_back(client->async_inversion(0, 30s, Lane::Bulk));
+    }
+    // a cancelled inversion succeeds without reaching the device
+    for (auto& result : results) {
+        REQUIRE_FALSE(result.get());
+    }
+
+    auto stats = client->stats();
+    REQUIRE(stats.commands_coalesced > 0);
+    REQUIRE(stats.commands_coalesced % 2 == 0);
+    REQUIRE(device.commands() + stats.commands_coalesced == commands);
+
+    client.reset();
+    work_guard.reset();
+    io.stop();
+    asio_worker.join();
+}
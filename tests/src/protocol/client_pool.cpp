@@ -0,0 +1,141 @@
+#include "catch2/catch.hpp"
+
+#include "client_pool/client_pool.hpp"
+#include "fixture/fake_device.hpp"
+#include "fixture/test_utils.hpp"
+
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+TEST_CASE("Client pool: a cached device at a stale address is moved from the io thread", "[client_pool]")
+{
+    using namespace tsvetkov;
+    test::register_endian_conversion();
+
+    test::FakeDevice device;
+
+    asio::io_context io;
+    asio::executor_work_guard<asio::io_context::executor_type> work_guard(io.get_executor());
+    auto asio_worker = std::thread([&] { io.run(); });
+
+    ClientOptions options;
+    options.reconnect_initial_delay = 10ms;
+    ClientPool pool(io, device.port(), options);
+
+    // the cache remembers an address nothing listens on any more; the fake device numbers its strips from 0
+    auto id = make_device_id(0, 0);
+    pool.add(FoundDevice(protocol::DeviceType::SmartPowerStrip, 0, 0, "127.0.0.2"));
+
+    // discovery reports the device where it really is, from the io thread as the finder's handlers run
+    asio::post(io, [&] { pool.add_or_move(FoundDevice(protocol::DeviceType::SmartPowerStrip, 0, 0, "127.0.0.1")); });
+    REQUIRE(test::wait_until(
+        [&] {
+            auto client = pool.find(id);
+            return client && client->connection_state() == ConnectionState::Connected;
+        },
+        5s));
+    REQUIRE(pool.size() == 1);
+    REQUIRE(pool.find(id)->remote_address() == "127.0.0.1");
+    REQUIRE_FALSE(pool.find(id)->async_send_all_on().get());
+
+    // the stale client's status board slot is released once it is disconnected
+    auto present = [&] {
+        std::size_t count = 0;
+        pool.status_board().for_each([&](const DeviceSnapshot&) { ++count; });
+        return count;
+    };
+    REQUIRE(test::wait_until([&] { return present() == 1; }, 5s));
+
+    work_guard.reset();
+    io.stop();
+    asio_worker.join();
+}
+
+TEST_CASE("Client pool: a cached address now taken by another device is not used", "[client_pool]")
+{
+    using namespace tsvetkov;
+    test::register_endian_conversion();
+
+    // answers as device 0:0 on the address the cache has for device 0:7
+    test::FakeDevice device;
+
+    asio::io_context io;
+    asio::executor_work_guard<asio::io_context::executor_type> work_guard(io.get_executor());
+    auto asio_worker = std::thread([&] { io.run(); });
+
+    ClientOptions options;
+    options.reconnect_initial_delay = 10ms;
+    ClientPool pool(io, device.port(), options);
+    auto client = pool.add(FoundDevice(protocol::DeviceType::SmartPowerStrip, 0, 7, "127.0.0.1"));
+
+    REQUIRE(test::wait_until([&] { return client->stats().wrong_devices >= 2; }, 5s));
+    REQUIRE(client->connection_state() != ConnectionState::Connected);
+    // nothing reached the wrong strip, and nothing was reported for it
+    REQUIRE(device.commands() == 0);
+    REQUIRE(client->snapshot().notifications == 0);
+
+    work_guard.reset();
+    io.stop();
+    asio_worker.join();
+}
+
+TEST_CASE("Client pool: removal handlers run for removed devices only", "[client_pool]")
+{
+    using namespace tsvetkov;
+    test::register_endian_conversion();
+
+    test::FakeDevice device;
+
+    asio::io_context io;
+    asio::executor_work_guard<asio::io_context::executor_type> work_guard(io.get_executor());
+    auto asio_worker = std::thread([&] { io.run(); });
+
+    ClientOptions options;
+    options.reconnect_initial_delay = 10ms;
+    ClientPool pool(io, device.port(), options);
+
+    std::mutex mutex;
+    std::vector<DeviceId> removed;
+    pool.add_removal_handler([&](DeviceId id) {
+        std::lock_guard lock_guard(mutex);
+        removed.push_back(id);
+    });
+
+    auto id = make_device_id(0, 0);
+    pool.add(FoundDevice(protocol::DeviceType::SmartPowerStrip, 0, 0, "127.0.0.2"));
+
+    // a move keeps the device in the pool
+    pool.add_or_move(FoundDevice(protocol::DeviceType::SmartPowerStrip, 0, 0, "127.0.0.1"));
+    REQUIRE(test::wait_until(
+        [&] {
+            auto client = pool.find(id);
+            return client && client->connection_state() == ConnectionState::Connected;
+        },
+        5s));
+    // the moved-from client is disconnected once its status board slot is released
+    auto present = [&] {
+        std::size_t count = 0;
+        pool.status_board().for_each([&](const DeviceSnapshot&) { ++count; });
+        return count;
+    };
+    REQUIRE(test::wait_until([&] { return present() == 1; }, 5s));
+    {
+        std::lock_guard lock_guard(mutex);
+        REQUIRE(removed.empty());
+    }
+
+    REQUIRE(pool.remove(id).get());
+    REQUIRE_FALSE(pool.remove(id).get());
+    {
+        std::lock_guard lock_guard(mutex);
+        REQUIRE(removed == std::vector<DeviceId>{id});
+    }
+
+    work_guard.reset();
+    io.stop();
+    asio_worker.join();
+}
@@ -0,0 +1,58 @@
+#include "catch2/catch.hpp"
+
+#include "client/client.hpp"
+#include "fixture/fake_device.hpp"
+#include "fixture/test_utils.hpp"
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+TEST_CASE("Client: gathered writes the socket takes only part of arrive intact", "[client]")
+{
+    using namespace tsvetkov;
+    test::register_endian_conversion();
+
+    constexpr std::size_t commands = 60000;
+
+    test::FakeDevice device;
+
+    asio::io_context io;
+    asio::executor_work_guard<asio::io_context::executor_type> work_guard(io.get_executor());
+    auto asio_worker = std::thread([&] { io.run(); });
+
+    // A small send buffer and large gathers: a write rarely fits whole, and the cut often falls inside a frame.
+    ClientOptions options;
+    options.send_buffer_size     = 4096;
+    options.max_write_frames     = 32768;
+    options.max_write_bytes      = 1024 * 1024;
+    options.max_queued_frames    = 2 * commands;
+    options.max_pending_requests = 2 * commands;
+    options.coalesce_commands    = false;
+    options.request_timeout      = 30s;
+    auto client                  = std::make_shared<Client>(io, "127.0.0.1", device.port(), options);
+    client->connect();
+
+    std::vector<pc::future<Client::command_result_type>> results;
+    results.reserve(commands);
+    for (std::size_t i = 0; i < commands; ++i) {
+        results.push_back(client->async_inversion(static_cast<std::uint8_t>(i % 8)));
+    }
+    // every frame parsed and acknowledged by the device, none lost or torn at a cut
+    for (auto& result : results) {
+        REQUIRE_FALSE(result.get());
+    }
+    REQUIRE(device.commands() == commands);
+
+    auto stats = client->stats();
+    REQUIRE(stats.partial_writes > 0);
+    REQUIRE(stats.write_syscalls > stats.partial_writes);
+    REQUIRE(stats.link_drops == 0);
+
+    client.reset();
+    work_guard.reset();
+    io.stop();
+    asio_worker.join();
+}
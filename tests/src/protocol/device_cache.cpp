@@ -0,0 +1,77 @@
+#include "catch2/catch.hpp"
+
+#include "client_finder/device_cache.hpp"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+using namespace std::chrono_literals;
+
+namespace {
+std::string cache_path(const char* name)
+{
+    auto path = (std::filesystem::temp_directory_path() / name).string();
+    std::remove(path.c_str());
+    return path;
+}
+} // namespace
+
+TEST_CASE("Device cache: survives a restart", "[device_cache]")
+{
+    using namespace tsvetkov;
+
+    auto path = cache_path("device_cache_restart.devices");
+    auto now  = DeviceCache::clock_type::now();
+    {
+        DeviceCache cache(path);
+        REQUIRE_FALSE(cache.load());
+        cache.update(FoundDevice(protocol::DeviceType::SmartPowerStrip, 1, 2, "10.0.0.2"), now - 1h);
+        cache.update(FoundDevice(protocol::DeviceType::SmartPowerStrip, 1, 3, "10.0.0.3"), now);
+        cache.update(FoundDevice(protocol::DeviceType::SmartPowerStrip, 1, 4, "10.0.0.4"), now - 2h);
+        REQUIRE(cache.remove(make_device_id(1, 4)));
+        REQUIRE(cache.save());
+    }
+
+    DeviceCache cache(path);
+    REQUIRE(cache.load());
+    auto devices = cache.devices();
+    REQUIRE(devices.size() == 2);
+    // most recently seen first
+    REQUIRE(devices[0] == FoundDevice(protocol::DeviceType::SmartPowerStrip, 1, 3, "10.0.0.3"));
+    REQUIRE(devices[1] == FoundDevice(protocol::DeviceType::SmartPowerStrip, 1, 2, "10.0.0.2"));
+
+    // discovery found a device elsewhere
+    cache.update(FoundDevice(protocol::DeviceType::SmartPowerStrip, 1, 2, "10.0.0.20"), now + 1s);
+    REQUIRE(cache.save());
+    REQUIRE(cache.load());
+    REQUIRE(cache.size() == 2);
+    REQUIRE(cache.devices()[0].ip_address == "10.0.0.20");
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Device cache: an unusable file is ignored", "[device_cache]")
+{
+    using namespace tsvetkov;
+
+    auto path = cache_path("device_cache_unusable.devices");
+    {
+        DeviceCache cache(path);
+        for (std::uint32_t id = 0; id < 10; ++id) {
+            cache.update(FoundDevice(protocol::DeviceType::SmartPowerStrip, 0, id, "10.0.0.1"));
+        }
+        REQUIRE(cache.save());
+    }
+    auto size = std::filesystem::file_size(path);
+    REQUIRE(size == 16 + 10 * 24);
+
+    std::filesystem::resize_file(path, size - 1);
+    DeviceCache cache(path);
+    REQUIRE_FALSE(cache.load());
+    REQUIRE(cache.size() == 0);
+
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << "not a device cache";
+    REQUIRE_FALSE(cache.load());
+    REQUIRE(cache.size() == 0);
+    std::remove(path.c_str());
+}
@@ -0,0 +1,115 @@
+#include "catch2/catch.hpp"
+
+#include "client_finder/device_registry.hpp"
+
+#include <algorithm>
+#include <random>
+#include <unordered_map>
+
+using namespace std::chrono_literals;
+
+namespace {
+constexpr auto strip = tsvetkov::protocol::DeviceType::SmartPowerStrip;
+
+asio::ip::address_v4 address(std::uint32_t host)
+{
+    return asio::ip::address_v4((192u << 24) | (168u << 16) | host);
+}
+} // namespace
+
+TEST_CASE("Device registry: new, seen and moved devices", "[device_registry]")
+{
+    using namespace tsvetkov;
+    DeviceRegistry registry;
+    auto now = DeviceRegistry::clock_type::now();
+
+    REQUIRE(registry.see(make_device_id(1, 2), strip, address(10), now).kind == SightingKind::New);
+    REQUIRE(registry.see(make_device_id(1, 2), strip, address(10), now + 1s).kind == SightingKind::Seen);
+    auto moved = registry.see(make_device_id(1, 2), strip, address(11), now + 2s);
+    REQUIRE(moved.kind == SightingKind::AddressChanged);
+    REQUIRE(moved.previous_address == address(10));
+    REQUIRE(registry.size() == 1);
+
+    auto entry = registry.find(make_device_id(1, 2));
+    REQUIRE(entry);
+    REQUIRE(entry->address == address(11));
+    REQUIRE(entry->last_seen == now + 2s);
+    REQUIRE_FALSE(registry.find(make_device_id(2, 1)));
+    REQUIRE(sizeof(DeviceRegistry::Entry) <= 24);
+}
+
+TEST_CASE("Device registry: devices not seen within the TTL expire", "[device_registry]")
+{
+    using namespace tsvetkov;
+    DeviceRegistry registry;
+    auto now = DeviceRegistry::clock_type::now();
+    for (std::uint32_t id = 0; id < 100; ++id) {
+        registry.see(id, strip, address(id), now);
+    }
+    for (std::uint32_t id = 0; id < 100; id += 2) {
+        registry.see(id, strip, address(id), now + 10s);
+    }
+
+    std::vector<DeviceId> expired;
+    auto count = registry.expire(now + 5s, [&](const DeviceRegistry::Entry& entry) { expired.push_back(entry.id); });
+    REQUIRE(count == 50);
+    REQUIRE(registry.size() == 50);
+    std::sort(expired.begin(), expired.end());
+    for (std::size_t i = 0; i < expired.size(); ++i) {
+        REQUIRE(expired[i] == 2 * i + 1);
+    }
+    for (std::uint32_t id = 0; id < 100; ++id) {
+        REQUIRE((registry.find(id) != nullptr) == (id % 2 == 0));
+    }
+    // an expired device answering again is new
+    REQUIRE(registry.see(1, strip, address(1), now + 20s).kind == SightingKind::New);
+}
+
+TEST_CASE("Device registry: agrees with a hash map under churn", "[device_registry]")
+{
+    using namespace tsvetkov;
+    DeviceRegistry registry(4);
+    std::unordered_map<DeviceId, std::uint32_t> reference;
+    std::minstd_rand random(7);
+    auto now = DeviceRegistry::clock_type::now();
+
+    for (int step = 0; step < 200000; ++step) {
+        DeviceId id = random() % 3000;
+        if (random() % 3 == 0) {
+            REQUIRE(registry.remove(id) == (reference.erase(id) == 1));
+        } else {
+            auto host     = static_cast<std::uint32_t>(random() % 4);
+            auto sighting = registry.see(id, strip, address(host), now);
+            auto it       = reference.find(id);
+            if (it == reference.end()) {
+                REQUIRE(sighting.kind == SightingKind::New);
+                reference.emplace(id, host);
+            } else {
+                REQUIRE(sighting.kind == (it->second == host ? SightingKind::Seen : SightingKind::AddressChanged));
+                it->second = host;
+            }
+        }
+    }
+    REQUIRE(registry.size() == reference.size());
+    for (DeviceId id = 0; id < 3000; ++id) {
+        auto entry = registry.find(id);
+        auto it    = reference.find(id);
+        REQUIRE((entry != nullptr) == (it != reference.end()));
+        if (entry) {
+            REQUIRE(entry->address == address(it->second));
+        }
+    }
+}
+
+TEST_CASE("Device registry: counts devices by when they were last seen", "[device_registry]")
+{
+    using namespace tsvetkov;
+    DeviceRegistry registry;
+    auto now = DeviceRegistry::clock_type::now();
+    for (std::uint32_t id = 0; id < 10; ++id) {
+        registry.see(id, strip, address(id), now + std::chrono::seconds(id));
+    }
+    REQUIRE(registry.count_seen_between(now, now + 10s) == 10);
+    REQUIRE(registry.count_seen_between(now + 2s, now + 5s) == 3);
+    REQUIRE(registry.count_seen_between(now + 20s, now + 30s) == 0);
+}
@@ -0,0 +1,69 @@
+#include "catch2/catch.hpp"
+
+#include "common/exponential_backoff.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+using namespace std::chrono_literals;
+using tsvetkov::ExponentialBackoff;
+
+TEST_CASE("Exponential backoff: delays stay within the doubling cap", "[exponential_backoff]")
+{
+    // the cap of attempt n is 100 ms * 2^n, up to 1 s from the fifth attempt on
+    const std::vector<ExponentialBackoff::duration_type> caps = {100ms, 200ms, 400ms, 800ms, 1s, 1s, 1s};
+
+    std::vector<ExponentialBackoff::duration_type> longest(caps.size(), ExponentialBackoff::duration_type::zero());
+    std::vector<ExponentialBackoff::duration_type> shortest(caps.size(), 1h);
+    // spread out seeds: the engine's first draw for small consecutive seeds is small too
+    for (std::uint64_t client = 1; client <= 1000; ++client) {
+        ExponentialBackoff backoff(100ms, 1s, client * 2654435761u);
+        for (std::size_t attempt = 0; attempt < caps.size(); ++attempt) {
+            REQUIRE(backoff.attempt() == attempt);
+            auto delay = backoff.next();
+            REQUIRE(delay >= ExponentialBackoff::duration_type::zero());
+            REQUIRE(delay <= caps[attempt]);
+            longest[attempt]  = std::max(longest[attempt], delay);
+            shortest[attempt] = std::min(shortest[attempt], delay);
+        }
+    }
+    // full jitter: the draws cover the whole window, not just its upper end
+    for (std::size_t attempt = 0; attempt < caps.size(); ++attempt) {
+        REQUIRE(longest[attempt] > caps[attempt] * 9 / 10);
+        REQUIRE(shortest[attempt] < caps[attempt] / 10);
+    }
+}
+
+TEST_CASE("Exponential backoff: reset starts over from the initial cap", "[exponential_backoff]")
+{
+    ExponentialBackoff backoff(10ms, 10s, 42);
+    for (int i = 0; i < 10; ++i) {
+        backoff.next();
+    }
+    REQUIRE(backoff.attempt() == 10);
+
+    backoff.reset();
+    REQUIRE(backoff.attempt() == 0);
+    REQUIRE(backoff.next() <= 10ms);
+
+    // a maximum below the initial delay is raised to it
+    ExponentialBackoff flat(50ms, 1ms, 7);
+    for (int i = 0; i < 100; ++i) {
+        REQUIRE(flat.next() <= 50ms);
+    }
+}
+
+TEST_CASE("Exponential backoff: the same seed gives the same delays", "[exponential_backoff]")
+{
+    ExponentialBackoff a(100ms, 1s, 1234);
+    ExponentialBackoff b(100ms, 1s, 1234);
+    ExponentialBackoff other(100ms, 1s, 4321);
+    bool differs = false;
+    for (int i = 0; i < 20; ++i) {
+        auto delay = a.next();
+        REQUIRE(delay == b.next());
+        differs = differs || delay != other.next();
+    }
+    REQUIRE(differs);
+}
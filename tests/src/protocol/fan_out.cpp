@@ -0,0 +1,60 @@
+#include "catch2/catch.hpp"
+
+#include "client/fan_out.hpp"
+#include "fixture/fake_device.hpp"
+#include "fixture/test_utils.hpp"
+
+#include <chrono>
+#include <memory>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+TEST_CASE("Fan out: one failing client does not fail the others", "[fan_out]")
+{
+    using namespace tsvetkov;
+    test::register_endian_conversion();
+
+    test::FakeDevice device;
+    // acknowledges nothing: its client's command times out
+    test::FakeDevice silent_device;
+    silent_device.set_muted(true);
+
+    asio::io_context io;
+    asio::executor_work_guard<asio::io_context::executor_type> work_guard(io.get_executor());
+    auto asio_worker = std::thread([&] { io.run(); });
+
+    std::vector<std::shared_ptr<Client>> clients;
+    for (int i = 0; i < 3; ++i) {
+        clients.push_back(std::make_shared<Client>(io, "127.0.0.1", device.port()));
+    }
+    clients.insert(clients.begin() + 1, std::make_shared<Client>(io, "127.0.0.1", silent_device.port()));
+    for (auto& client : clients) {
+        client->connect();
+    }
+
+    auto started = std::chrono::steady_clock::now();
+    auto results = fan_out(clients, [](const auto& client) { return client->async_send_all_on(300ms); }).get();
+    // completed once the failing command hit its deadline, not before
+    REQUIRE(std::chrono::steady_clock::now() - started >= 300ms);
+
+    REQUIRE(results.size() == clients.size());
+    // results keep the order of the clients
+    try {
+        results[1].get();
+        FAIL("the command of the silent device succeeded");
+    } catch (const std::system_error& e) {
+        REQUIRE(e.code() == std::errc::timed_out);
+    }
+    results.erase(results.begin() + 1);
+    REQUIRE(count_succeeded(results) == 3);
+    REQUIRE(device.commands() == 3);
+    REQUIRE(silent_device.commands() == 1);
+
+    clients.clear();
+    work_guard.reset();
+    io.stop();
+    asio_worker.join();
+}
@@ -0,0 +1,74 @@
+#include "catch2/catch.hpp"
+
+#include "fleet_index/fleet_index.hpp"
+
+#include <string>
+#include <vector>
+
+namespace {
+using Status = tsvetkov::FleetIndex::Status;
+
+tsvetkov::PinState make_state(const std::string& states)
+{
+    tsvetkov::PinState result;
+    for (std::size_t pin = 0; pin < states.size(); ++pin) {
+        result.set(static_cast<std::uint8_t>(pin), states[pin] == '1' ? Status::On : Status::Off);
+    }
+    return result;
+}
+} // namespace
+
+TEST_CASE("Fleet index: per pin queries", "[fleet_index]")
+{
+    tsvetkov::FleetIndex index;
+    index.update(10, make_state("1000"));
+    index.update(11, make_state("1100"));
+    index.update(12, make_state("0110"));
+    index.update(13, make_state("01"));
+
+    REQUIRE(index.size() == 4);
+    REQUIRE(index.powered_outlets() == 6);
+    REQUIRE(index.count(0, Status::On) == 2);
+    REQUIRE(index.count(1, Status::On) == 3);
+    REQUIRE(index.count(3, Status::Off) == 3);
+    REQUIRE(index.count(7, Status::Off) == 0);
+    REQUIRE(index.count({{0, Status::On}, {1, Status::On}}) == 1);
+    // a device without pin 2 has it neither on nor off
+    REQUIRE(index.count({{1, Status::On}, {2, Status::Off}}) == 1);
+    REQUIRE(index.count({}) == 4);
+    REQUIRE(index.device_ids(index.select(2, Status::On)) == std::vector<tsvetkov::DeviceId>{12});
+
+    auto on = index.select(0, Status::On);
+    on |= index.select(2, Status::On);
+    REQUIRE(on.count() == 3);
+    on.subtract(index.select(1, Status::On));
+    REQUIRE(index.device_ids(on) == std::vector<tsvetkov::DeviceId>{10});
+}
+
+TEST_CASE("Fleet index: updates and removal", "[fleet_index]")
+{
+    tsvetkov::FleetIndex index;
+    for (tsvetkov::DeviceId id = 0; id < 1000; ++id) {
+        index.update(id, make_state(id % 2 ? "11" : "00"));
+    }
+    REQUIRE(index.powered_outlets() == 1000);
+    REQUIRE(index.count(1, Status::On) == 500);
+
+    index.update(0, make_state("01"));
+    index.update(1, make_state("0"));
+    REQUIRE(index.powered_outlets() == 999);
+    REQUIRE(index.count(1, Status::Off) == 499);
+    REQUIRE(index.count(1, Status::On) == 500);
+
+    REQUIRE(index.remove(3));
+    REQUIRE_FALSE(index.remove(3));
+    REQUIRE(index.size() == 999);
+    REQUIRE(index.powered_outlets() == 997);
+    REQUIRE(index.count(0, Status::On) == 498);
+
+    // the row is reused without inheriting anything
+    index.update(5000, make_state("0"));
+    REQUIRE(index.count(1, Status::On) == 499);
+    REQUIRE(index.count(0, Status::Off) == 502);
+    REQUIRE(index.count({{0, Status::Off}, {1, Status::Off}}) == 499);
+}
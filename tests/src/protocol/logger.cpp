@@ -0,0 +1,160 @@
+#include "catch2/catch.hpp"
+
+#include "common/logger.hpp"
+
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+// Collects the lines of the global logger for the duration of a test, then puts back the sink and level it found.
+class CapturedLog
+{
+public:
+    explicit CapturedLog(tsvetkov::LogLevel level) : previous_level_(tsvetkov::Logger::instance().level())
+    {
+        auto& logger = tsvetkov::Logger::instance();
+        logger.set_level(level);
+        previous_sink_ = logger.set_sink([this](std::string_view lines) {
+            std::lock_guard lock_guard(mutex_);
+            while (!lines.empty()) {
+                auto end = lines.find('\n');
+                lines_.emplace_back(lines.substr(0, end));
+                lines.remove_prefix(end + 1);
+            }
+        });
+    }
+
+    ~CapturedLog()
+    {
+        auto& logger = tsvetkov::Logger::instance();
+        logger.flush();
+        logger.set_sink(std::move(previous_sink_));
+        logger.set_level(previous_level_);
+    }
+
+    std::vector<std::string> lines()
+    {
+        tsvetkov::Logger::instance().flush();
+        std::lock_guard lock_guard(mutex_);
+        return lines_;
+    }
+
+private:
+    tsvetkov::LogLevel previous_level_;
+    tsvetkov::Logger::sink_type previous_sink_;
+    std::mutex mutex_;
+    std::vector<std::string> lines_;
+};
+
+bool ends_with(const std::string& line, std::string_view suffix)
+{
+    return line.size() >= suffix.size() && line.compare(line.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+} // namespace
+
+TEST_CASE("Logger: formats arguments into one line", "[logger]")
+{
+    using namespace tsvetkov;
+    CapturedLog log(LogLevel::Trace);
+    log_info("client", "pin ", std::uint8_t{3}, " is ", true, ", rto ", 1.5, " ms, ", -42, ' ', std::string("x"));
+    log_warning("finder", std::make_error_code(std::errc::timed_out));
+
+    auto lines = log.lines();
+    REQUIRE(lines.size() == 2);
+    REQUIRE(ends_with(lines[0], " info client: pin 3 is true, rto 1.5 ms, -42 x"));
+    REQUIRE(lines[0][4] == '-');
+    REQUIRE(lines[0][10] == 'T');
+    REQUIRE(ends_with(lines[1], "warning finder: generic:" + std::to_string(ETIMEDOUT)));
+}
+
+TEST_CASE("Logger: a capture puts the previous sink back", "[logger]")
+{
+    using namespace tsvetkov;
+    CapturedLog outer(LogLevel::Info);
+    {
+        CapturedLog inner(LogLevel::Trace);
+        log_debug("client", "inner");
+        REQUIRE(inner.lines().size() == 1);
+    }
+    REQUIRE(Logger::instance().level() == LogLevel::Info);
+    log_info("client", "outer");
+
+    auto lines = outer.lines();
+    REQUIRE(lines.size() == 1);
+    REQUIRE(ends_with(lines[0], "info client: outer"));
+}
+
+TEST_CASE("Logger: an empty sink means stdout", "[logger]")
+{
+    using namespace tsvetkov;
+    CapturedLog log(LogLevel::Info);
+    auto captured = Logger::instance().set_sink({});
+    auto standard = Logger::instance().set_sink(std::move(captured));
+    REQUIRE(standard);
+}
+
+TEST_CASE("Logger: levels below the threshold are skipped", "[logger]")
+{
+    using namespace tsvetkov;
+    CapturedLog log(LogLevel::Warning);
+    log_debug("client", "debug");
+    log_info("client", "info");
+    log_error("client", "error");
+    REQUIRE_FALSE(log_enabled<LogLevel::Info>());
+    REQUIRE(log_enabled<LogLevel::Error>());
+
+    auto lines = log.lines();
+    REQUIRE(lines.size() == 1);
+    REQUIRE(ends_with(lines[0], "error client: error"));
+}
+
+TEST_CASE("Logger: long text is cut off", "[logger]")
+{
+    using namespace tsvetkov;
+    CapturedLog log(LogLevel::Info);
+    log_info("client", std::string(1000, 'a'));
+
+    auto lines = log.lines();
+    REQUIRE(lines.size() == 1);
+    REQUIRE(ends_with(lines[0], "client: " + std::string(LogRecord::max_text, 'a')));
+}
+
+TEST_CASE("Logger: lines of each thread keep their order", "[logger]")
+{
+    using namespace tsvetkov;
+    constexpr int threads = 4;
+    constexpr int lines   = 300;
+    CapturedLog log(LogLevel::Info);
+    auto before = Logger::instance().stats();
+
+    std::vector<std::thread> workers;
+    for (int thread = 0; thread < threads; ++thread) {
+        workers.emplace_back([thread] {
+            for (int line = 0; line < lines; ++line) {
+                log_info("worker", thread, ' ', line);
+                if (line % 100 == 99) {
+                    Logger::instance().flush();
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    std::vector<int> next(threads, 0);
+    for (const auto& line : log.lines()) {
+        auto text   = line.substr(line.find("worker: ") + 8);
+        auto thread = std::stoi(text.substr(0, text.find(' ')));
+        auto number = std::stoi(text.substr(text.find(' ') + 1));
+        REQUIRE(number == next[thread]);
+        ++next[thread];
+    }
+    REQUIRE(next == std::vector<int>(threads, lines));
+    auto after = Logger::instance().stats();
+    REQUIRE(after.written - before.written == threads * lines);
+    REQUIRE(after.dropped == before.dropped);
+}
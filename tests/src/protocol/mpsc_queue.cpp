@@ -0,0 +1,69 @@
+#include "catch2/catch.hpp"
+
+#include "common/mpsc_queue.hpp"
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+struct Item : tsvetkov::MpscQueueNode
+{
+    Item(std::size_t producer, std::size_t sequence) : producer(producer), sequence(sequence) {}
+
+    std::size_t producer;
+    std::size_t sequence;
+};
+} // namespace
+
+TEST_CASE("MPSC queue: single thread", "[mpsc_queue]")
+{
+    tsvetkov::MpscQueue<Item> queue;
+    REQUIRE(queue.pop() == nullptr);
+
+    Item a(0, 0), b(0, 1), c(0, 2);
+    queue.push(&a);
+    queue.push(&b);
+    REQUIRE(queue.pop() == &a);
+    queue.push(&c);
+    REQUIRE(queue.pop() == &b);
+    REQUIRE(queue.pop() == &c);
+    REQUIRE(queue.pop() == nullptr);
+
+    queue.push(&a);
+    REQUIRE(queue.pop() == &a);
+    REQUIRE(queue.pop() == nullptr);
+}
+
+TEST_CASE("MPSC queue: producers keep their order", "[mpsc_queue]")
+{
+    constexpr std::size_t producers = 8;
+    constexpr std::size_t items     = 20000;
+
+    tsvetkov::MpscQueue<Item> queue;
+    std::vector<std::thread> threads;
+    for (std::size_t producer = 0; producer < producers; ++producer) {
+        threads.emplace_back([&queue, producer] {
+            for (std::size_t sequence = 0; sequence < items; ++sequence) {
+                queue.push(new Item(producer, sequence));
+            }
+        });
+    }
+
+    std::vector<std::size_t> expected(producers, 0);
+    std::size_t received = 0;
+    while (received < producers * items) {
+        std::unique_ptr<Item> item(queue.pop());
+        if (!item) {
+            std::this_thread::yield();
+            continue;
+        }
+        REQUIRE(item->sequence == expected[item->producer]);
+        ++expected[item->producer];
+        ++received;
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    REQUIRE(queue.pop() == nullptr);
+}
@@ -0,0 +1,197 @@
+#include "catch2/catch.hpp"
+
+#include "client/output_queue.hpp"
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace {
+tsvetkov::Frame make_frame(char tag)
+{
+    return tsvetkov::Frame(std::array<char, 1>{tag});
+}
+
+std::string drain(tsvetkov::OutputQueue& queue, std::size_t n)
+{
+    std::string result;
+    for (std::size_t i = 0; i < n && !queue.empty(); ++i) {
+        result += queue.front().data()[0];
+        queue.pop_front();
+    }
+    return result;
+}
+} // namespace
+
+TEST_CASE("Output queue: control frames never wait behind other lanes", "[output_queue]")
+{
+    using tsvetkov::Lane;
+    tsvetkov::OutputQueue queue(10000, 4);
+
+    for (int i = 0; i < 5000; ++i) {
+        REQUIRE(queue.push(Lane::Bulk, make_frame('b')));
+    }
+    REQUIRE(queue.push(Lane::Control, make_frame('c')));
+    REQUIRE(drain(queue, 1) == "c");
+    REQUIRE(queue.size() == 5000);
+}
+
+TEST_CASE("Output queue: weighted interactive and bulk lanes", "[output_queue]")
+{
+    using tsvetkov::Lane;
+    tsvetkov::OutputQueue queue(100, 4);
+
+    for (int i = 0; i < 10; ++i) {
+        queue.push(Lane::Interactive, make_frame('i'));
+        queue.push(Lane::Bulk, make_frame('b'));
+    }
+    REQUIRE(drain(queue, 10) == "iiiibiiiib");
+    queue.push(Lane::Control, make_frame('c'));
+    REQUIRE(drain(queue, 11) == "ciibbbbbbbb");
+    REQUIRE(queue.empty());
+}
+
+TEST_CASE("Output queue: order is kept within a lane only", "[output_queue]")
+{
+    using tsvetkov::Lane;
+    tsvetkov::OutputQueue queue(100, 4);
+
+    queue.push(Lane::Bulk, make_frame('1'));
+    queue.push(Lane::Bulk, make_frame('2'));
+    queue.push(Lane::Interactive, make_frame('a'));
+    queue.push(Lane::Interactive, make_frame('b'));
+    // the later interactive frames overtake the bulk ones, each lane staying in order
+    REQUIRE(drain(queue, 4) == "ab12");
+}
+
+TEST_CASE("Output queue: bounded lanes", "[output_queue]")
+{
+    using tsvetkov::Lane;
+    tsvetkov::OutputQueue queue(3, 4);
+
+    for (int i = 0; i < 3; ++i) {
+        REQUIRE(queue.push(Lane::Bulk, make_frame('b')));
+    }
+    REQUIRE_FALSE(queue.push(Lane::Bulk, make_frame('b')));
+    REQUIRE(queue.push(Lane::Interactive, make_frame('i')));
+    REQUIRE(queue.push(Lane::Control, make_frame('c')));
+    REQUIRE(queue.size(Lane::Bulk) == 3);
+
+    queue.clear();
+    REQUIRE(queue.empty());
+    REQUIRE(queue.push(Lane::Bulk, make_frame('b')));
+}
+
+namespace {
+struct Elided
+{
+    void operator()(std::uint32_t id, std::optional<std::uint32_t> superseded_by)
+    {
+        ids.push_back(id);
+        superseded.push_back(superseded_by);
+    }
+
+    std::vector<std::uint32_t> ids;
+    std::vector<std::optional<std::uint32_t>> superseded;
+};
+} // namespace
+
+TEST_CASE("Output queue: inversions of the same pin cancel out", "[output_queue]")
+{
+    using tsvetkov::FrameEffect;
+    using tsvetkov::Lane;
+    using tsvetkov::PushResult;
+    tsvetkov::OutputQueue queue(100, 4);
+    Elided elided;
+
+    REQUIRE(queue.push_command(Lane::Interactive, make_frame('1'), FrameEffect::Toggle, 1, 10, elided) ==
+            PushResult::Queued);
+    REQUIRE(queue.push_command(Lane::Interactive, make_frame('2'), FrameEffect::Toggle, 2, 11, elided) ==
+            PushResult::Queued);
+    REQUIRE(queue.push_command(Lane::Interactive, make_frame('1'), FrameEffect::Toggle, 1, 12, elided) ==
+            PushResult::Cancelled);
+    REQUIRE(elided.ids == std::vector<std::uint32_t>{10});
+    REQUIRE_FALSE(elided.superseded[0]);
+    REQUIRE(queue.size() == 1);
+
+    // a third inversion is queued again, and only frames of the same lane are considered
+    REQUIRE(queue.push_command(Lane::Interactive, make_frame('1'), FrameEffect::Toggle, 1, 13, elided) ==
+            PushResult::Queued);
+    REQUIRE(queue.push_command(Lane::Bulk, make_frame('1'), FrameEffect::Toggle, 1, 14, elided) ==
+            PushResult::Queued);
+    REQUIRE(drain(queue, 3) == "211");
+
+    // a written frame is out of reach
+    REQUIRE(queue.push_command(Lane::Interactive, make_frame('1'), FrameEffect::Toggle, 1, 15, elided) ==
+            PushResult::Queued);
+    REQUIRE(elided.ids.size() == 1);
+}
+
+TEST_CASE("Output queue: all on / all off supersede earlier commands", "[output_queue]")
+{
+    using tsvetkov::FrameEffect;
+    using tsvetkov::Lane;
+    using tsvetkov::PushResult;
+    tsvetkov::OutputQueue queue(100, 4);
+    Elided elided;
+
+    queue.push(Lane::Interactive, make_frame('x'));
+    queue.push_command(Lane::Interactive, make_frame('1'), FrameEffect::Toggle, 1, 1, elided);
+    queue.push_command(Lane::Interactive, make_frame('A'), FrameEffect::SetAll, 0, 2, elided);
+    queue.push_command(Lane::Interactive, make_frame('2'), FrameEffect::Toggle, 2, 3, elided);
+    REQUIRE(queue.push_command(Lane::Interactive, make_frame('B'), FrameEffect::SetAll, 0, 4, elided) ==
+            PushResult::Queued);
+    REQUIRE(elided.ids == std::vector<std::uint32_t>{1, 2, 3});
+    REQUIRE(elided.superseded == std::vector<std::optional<std::uint32_t>>{2, 4, 4});
+
+    // the toggle before the last all on / all off is gone, this one is queued
+    REQUIRE(queue.push_command(Lane::Interactive, make_frame('1'), FrameEffect::Toggle, 1, 5, elided) ==
+            PushResult::Queued);
+    REQUIRE(drain(queue, 10) == "xB1");
+    REQUIRE(queue.empty());
+}
+
+TEST_CASE("Output queue: cancelled frames free their place in the lane", "[output_queue]")
+{
+    using tsvetkov::FrameEffect;
+    using tsvetkov::Lane;
+    using tsvetkov::PushResult;
+    tsvetkov::OutputQueue queue(2, 4);
+    Elided elided;
+
+    for (std::uint32_t id = 0; id < 1000; ++id) {
+        REQUIRE(queue.push_command(Lane::Bulk, make_frame('1'), FrameEffect::Toggle, 1, id, elided) !=
+                PushResult::Rejected);
+    }
+    REQUIRE(queue.empty());
+    queue.push_command(Lane::Bulk, make_frame('1'), FrameEffect::Toggle, 1, 1000, elided);
+    queue.push_command(Lane::Bulk, make_frame('2'), FrameEffect::Toggle, 2, 1001, elided);
+    REQUIRE(queue.push_command(Lane::Bulk, make_frame('3'), FrameEffect::Toggle, 3, 1002, elided) ==
+            PushResult::Rejected);
+    REQUIRE(queue.push_command(Lane::Bulk, make_frame('A'), FrameEffect::SetAll, 0, 1003, elided) ==
+            PushResult::Queued);
+    REQUIRE(drain(queue, 10) == "A");
+}
+
+TEST_CASE("Output queue: a cancelled frame inside the lane frees its place", "[output_queue]")
+{
+    using tsvetkov::FrameEffect;
+    using tsvetkov::Lane;
+    using tsvetkov::PushResult;
+    tsvetkov::OutputQueue queue(3, 4);
+    Elided elided;
+
+    queue.push(Lane::Bulk, make_frame('x'));
+    queue.push_command(Lane::Bulk, make_frame('1'), FrameEffect::Toggle, 1, 1, elided);
+    queue.push(Lane::Bulk, make_frame('y'));
+    REQUIRE_FALSE(queue.push(Lane::Bulk, make_frame('z')));
+
+    // the cancelled toggle stays behind as a tombstone between two live frames
+    REQUIRE(queue.push_command(Lane::Bulk, make_frame('1'), FrameEffect::Toggle, 1, 2, elided) ==
+            PushResult::Cancelled);
+    REQUIRE(queue.push(Lane::Bulk, make_frame('z')));
+    REQUIRE_FALSE(queue.push(Lane::Bulk, make_frame('w')));
+    REQUIRE(drain(queue, 10) == "xyz");
+}
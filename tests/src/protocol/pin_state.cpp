@@ -0,0 +1,60 @@
+#include "catch2/catch.hpp"
+
+#include "client/pin_state.hpp"
+
+#include <cstdint>
+#include <vector>
+
+TEST_CASE("Pin state: conversion from and to SmartPowerStatus", "[pin_state]")
+{
+    using Status = tsvetkov::protocol::SmartPowerStatus::Status;
+
+    tsvetkov::protocol::SmartPowerStatus status;
+    status.status.emplace(std::uint8_t{0}, Status::On);
+    status.status.emplace(std::uint8_t{63}, Status::Off);
+    status.status.emplace(std::uint8_t{64}, Status::On);
+    status.status.emplace(std::uint8_t{255}, Status::On);
+
+    auto state = tsvetkov::PinState::from_status(status);
+    REQUIRE(state.size() == 4);
+    REQUIRE(state.on.count() == 3);
+    REQUIRE(state.has(63));
+    REQUIRE(state.status(63) == Status::Off);
+    REQUIRE_FALSE(state.has(1));
+    REQUIRE(state.to_map() == status.status);
+
+    std::vector<std::uint8_t> pins;
+    state.present.for_each([&](std::uint8_t pin) { pins.push_back(pin); });
+    REQUIRE(pins == std::vector<std::uint8_t>{0, 63, 64, 255});
+}
+
+TEST_CASE("Pin state: diff and merge", "[pin_state]")
+{
+    using Status = tsvetkov::protocol::SmartPowerStatus::Status;
+
+    tsvetkov::PinState before;
+    tsvetkov::PinState after;
+    for (std::uint8_t pin = 0; pin < 200; ++pin) {
+        before.set(pin, Status::Off);
+        after.set(pin, Status::Off);
+    }
+    REQUIRE(tsvetkov::changed_pins(before, after).none());
+
+    after.set(7, Status::On);
+    after.set(130, Status::On);
+    after.set(250, Status::Off);
+    auto changed = tsvetkov::changed_pins(before, after);
+    REQUIRE(changed.count() == 3);
+    REQUIRE(changed.test(7));
+    REQUIRE(changed.test(130));
+    REQUIRE(changed.test(250));
+
+    tsvetkov::PinState desired;
+    desired.set(7, Status::Off);
+    desired.set(251, Status::On);
+    after.merge(desired);
+    REQUIRE(after.status(7) == Status::Off);
+    REQUIRE(after.status(130) == Status::On);
+    REQUIRE(after.status(251) == Status::On);
+    REQUIRE(after.size() == 202);
+}
@@ -0,0 +1,38 @@
+#include "catch2/catch.hpp"
+
+#include "client_finder/probe_schedule.hpp"
+
+using namespace std::chrono_literals;
+
+TEST_CASE("Probe schedule: fast while rounds bring news, then backs off", "[probe_schedule]")
+{
+    tsvetkov::ProbeSchedule schedule(250ms, 4s, 2);
+    REQUIRE(schedule.next(true) == 250ms);
+    REQUIRE(schedule.next(true) == 250ms);
+    REQUIRE(schedule.next(false) == 250ms);
+    REQUIRE(schedule.next(false) == 500ms);
+    REQUIRE(schedule.next(false) == 1s);
+    REQUIRE(schedule.next(false) == 2s);
+    REQUIRE(schedule.next(false) == 4s);
+    REQUIRE(schedule.next(false) == 4s);
+    REQUIRE(schedule.quiet_rounds() == 6);
+
+    // a device went missing: fast again
+    REQUIRE(schedule.next(true) == 250ms);
+    REQUIRE(schedule.quiet_rounds() == 0);
+    REQUIRE(schedule.next(false) == 250ms);
+}
+
+TEST_CASE("Probe schedule: a settled site costs far fewer probes than a fixed pace", "[probe_schedule]")
+{
+    tsvetkov::ProbeSchedule schedule(250ms, 60s, 4);
+    std::chrono::steady_clock::duration elapsed{};
+    std::size_t rounds = 0;
+    // news in the first rounds of a cold start only
+    while (elapsed < 1h) {
+        elapsed += schedule.next(rounds < 3);
+        ++rounds;
+    }
+    // 720 rounds every 5 seconds
+    REQUIRE(rounds < 80);
+}
@@ -0,0 +1,116 @@
+#include "catch2/catch.hpp"
+
+#include "client_pool/client_pool.hpp"
+#include "fixture/fake_device.hpp"
+#include "fixture/test_utils.hpp"
+#include "reconciler/command_plan.hpp"
+#include "reconciler/reconciler.hpp"
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+using tsvetkov::Command;
+using tsvetkov::PinState;
+using tsvetkov::PlannedCommand;
+using Status = tsvetkov::protocol::SmartPowerStatus::Status;
+
+// '1' on, '0' off, '-' no such pin / don't care
+PinState make_states(const std::string& states)
+{
+    PinState result;
+    for (std::size_t pin = 0; pin < states.size(); ++pin) {
+        if (states[pin] != '-') {
+            result.set(static_cast<std::uint8_t>(pin), states[pin] == '1' ? Status::On : Status::Off);
+        }
+    }
+    return result;
+}
+} // namespace
+
+TEST_CASE("Reconciler: shortest command plan", "[reconciler]")
+{
+    auto all_on  = PlannedCommand{Command::Type::AllOn, 0};
+    auto all_off = PlannedCommand{Command::Type::AllOff, 0};
+    auto invert  = [](std::uint8_t pin) { return PlannedCommand{Command::Type::Inversion, pin}; };
+
+    REQUIRE(tsvetkov::plan_commands(make_states("0101"), make_states("0101")).empty());
+    REQUIRE(tsvetkov::plan_commands(make_states("0101"), PinState()).empty());
+
+    // a couple of pins: inversions
+    REQUIRE(tsvetkov::plan_commands(make_states("00000000"), make_states("---1-1")) ==
+            std::vector<PlannedCommand>{invert(3), invert(5)});
+
+    // most pins: all on / all off plus the exceptions
+    REQUIRE(tsvetkov::plan_commands(make_states("00000000"), make_states("11111101")) ==
+            std::vector<PlannedCommand>{all_on, invert(6)});
+    REQUIRE(tsvetkov::plan_commands(make_states("11111111"), make_states("01000000")) ==
+            std::vector<PlannedCommand>{all_off, invert(1)});
+
+    // pins nobody asked for keep their state
+    REQUIRE(tsvetkov::plan_commands(make_states("00010000"), make_states("111-111")) ==
+            std::vector<PlannedCommand>{all_on, invert(7)});
+
+    // unknown pins are ignored
+    REQUIRE(tsvetkov::plan_commands(make_states("00"), make_states("---------1")).empty());
+}
+
+TEST_CASE("Reconciler: a plan reaches the desired state", "[reconciler]")
+{
+    for (auto [observed, desired] : {std::pair{"00000000", "11111101"}, std::pair{"10101010", "01010101"},
+                                     std::pair{"11110000", "11110001"}, std::pair{"11111111", "00000000"}}) {
+        auto plan = tsvetkov::plan_commands(make_states(observed), make_states(desired));
+        REQUIRE(tsvetkov::apply_commands(make_states(observed), plan) == make_states(desired));
+        REQUIRE(plan.size() <= 1 + 8 / 2);
+    }
+}
+
+TEST_CASE("Reconciler: devices converge and re-converge after a reconnect", "[reconciler]")
+{
+    using namespace tsvetkov;
+    using namespace std::chrono_literals;
+    test::register_endian_conversion();
+
+    test::FakeDevice device(8, true);
+
+    asio::io_context io;
+    asio::executor_work_guard<asio::io_context::executor_type> work_guard(io.get_executor());
+    auto asio_worker = std::thread([&] { io.run(); });
+
+    // one fake device answers for every strip, under ids of its own
+    ClientOptions options;
+    options.reconnect_initial_delay = 10ms;
+    options.verify_device_id        = false;
+    ClientPool pool(io, device.port(), options);
+    auto reconciler = Reconciler::create(pool);
+
+    constexpr std::uint32_t devices = 16;
+    for (std::uint32_t i = 0; i < devices; ++i) {
+        pool.add(FoundDevice(protocol::DeviceType::SmartPowerStrip, 0, i, "127.0.0.1"));
+        reconciler->set_desired(make_device_id(0, i), make_states(i % 2 ? "11111101" : "00100000"));
+    }
+    auto converged = [&] {
+        for (std::uint32_t i = 0; i < devices; ++i) {
+            if (!reconciler->is_converged(make_device_id(0, i))) {
+                return false;
+            }
+        }
+        return true;
+    };
+    REQUIRE(test::wait_until(converged, 10s));
+    REQUIRE(reconciler->stats().commands == devices / 2 * 2 + devices / 2);
+
+    // every strip comes back with all pins off and reports it in the handshake
+    auto commands = reconciler->stats().commands;
+    device.drop_all();
+    REQUIRE(test::wait_until([&] { return reconciler->stats().commands > commands && converged(); }, 10s));
+    REQUIRE(reconciler->stats().devices_in_flight == 0);
+
+    reconciler.reset();
+    work_guard.reset();
+    io.stop();
+    asio_worker.join();
+}
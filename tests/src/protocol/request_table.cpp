@@ -0,0 +1,58 @@
+#include <catch2/catch.hpp>
+
+#include "client/frame.hpp"
+#include "common/circular_queue.hpp"
+#include "common/request_table.hpp"
+
+namespace {
+struct PendingCommand
+{
+    std::uint32_t id = 0;
+    int result       = 0;
+};
+} // namespace
+
+TEST_CASE("Request table")
+{
+    tsvetkov::RequestTable<PendingCommand> table(5);
+    REQUIRE(table.capacity() == 8);
+
+    REQUIRE(table.insert(1, PendingCommand{1}));
+    REQUIRE_FALSE(table.is_free(1));
+    REQUIRE(table.is_free(2));
+    // same slot, next generation
+    REQUIRE_FALSE(table.insert(9, PendingCommand{9}));
+    REQUIRE(table.size() == 1);
+
+    // stale id of another generation does not match
+    REQUIRE_FALSE(table.take(9));
+    auto taken = table.take(1);
+    REQUIRE(taken);
+    REQUIRE(taken->id == 1);
+    REQUIRE_FALSE(table.take(1));
+
+    REQUIRE(table.insert(9, PendingCommand{9}));
+    REQUIRE(table.insert(10, PendingCommand{10}));
+    std::size_t taken_all = 0;
+    table.take_all([&taken_all](std::uint32_t id, PendingCommand command) {
+        REQUIRE(id == command.id);
+        ++taken_all;
+    });
+    REQUIRE(taken_all == 2);
+    REQUIRE(table.size() == 0);
+}
+
+TEST_CASE("Circular queue")
+{
+    tsvetkov::CircularQueue<int> queue(2);
+    for (int i = 0; i < 5; ++i) {
+        queue.emplace_back(i);
+    }
+    REQUIRE(queue.size() == 5);
+    REQUIRE(queue.capacity() == 8);
+    for (int i = 0; i < 5; ++i) {
+        REQUIRE(queue.front() == i);
+        queue.pop_front();
+    }
+    REQUIRE(queue.empty());
+}
@@ -0,0 +1,66 @@
+#include <catch2/catch.hpp>
+
+#include "common/ring_buffer.hpp"
+
+#include <cstring>
+#include <string>
+
+namespace {
+template<typename Ring>
+std::size_t write(Ring& ring, const std::string& data)
+{
+    std::size_t transferred = 0;
+    for (auto region : ring.prepare()) {
+        auto n = std::min(region.size(), data.size() - transferred);
+        std::memcpy(region.data(), data.data() + transferred, n);
+        transferred += n;
+    }
+    ring.commit(transferred);
+    return transferred;
+}
+} // namespace
+
+TEST_CASE("Ring buffer")
+{
+    tsvetkov::RingBuffer<16> ring;
+
+    REQUIRE(ring.empty());
+    REQUIRE(ring.free_space() == 16);
+
+    SECTION("contiguous frames are read in place")
+    {
+        REQUIRE(write(ring, "abcdef") == 6);
+        auto view = ring.peek(3);
+        REQUIRE(std::string(view, 3) == "abc");
+        ring.consume(3);
+        REQUIRE(std::string(ring.peek(3), 3) == "def");
+        ring.consume(3);
+        REQUIRE(ring.empty());
+        // empty ring starts over from the beginning
+        REQUIRE(ring.prepare()[0].size() == 16);
+        REQUIRE(ring.prepare()[1].size() == 0);
+    }
+
+    SECTION("frame wrapping around the end is linearized")
+    {
+        REQUIRE(write(ring, "0123456789ab") == 12);
+        ring.consume(10);
+        auto regions = ring.prepare();
+        REQUIRE(regions[0].size() == 4);
+        REQUIRE(regions[1].size() == 10);
+        REQUIRE(write(ring, "cdefgh") == 6);
+        REQUIRE(ring.size() == 8);
+        REQUIRE(std::string(ring.peek(8), 8) == "abcdefgh");
+        ring.consume(8);
+        REQUIRE(ring.empty());
+    }
+
+    SECTION("full ring has no free space")
+    {
+        REQUIRE(write(ring, std::string(20, 'x')) == 16);
+        REQUIRE(ring.free_space() == 0);
+        REQUIRE(ring.prepare()[0].size() + ring.prepare()[1].size() == 0);
+        ring.clear();
+        REQUIRE(ring.empty());
+    }
+}
@@ -0,0 +1,54 @@
+#include "catch2/catch.hpp"
+
+#include "common/rtt_estimator.hpp"
+
+#include <chrono>
+
+using namespace std::chrono_literals;
+
+TEST_CASE("RttEstimator", "[rtt]")
+{
+    tsvetkov::RttEstimator rtt(1s, 200ms, 4s, 10ms);
+    REQUIRE(rtt.samples() == 0);
+    REQUIRE(rtt.rto() == 1s);
+
+    SECTION("first sample")
+    {
+        rtt.add_sample(100ms);
+        REQUIRE(rtt.srtt() == 100ms);
+        REQUIRE(rtt.rttvar() == 50ms);
+        REQUIRE(rtt.rto() == 300ms);
+    }
+
+    SECTION("steady samples shrink the variation down to the minimum RTO")
+    {
+        for (int i = 0; i < 50; ++i) {
+            rtt.add_sample(20ms);
+        }
+        REQUIRE(rtt.srtt() == 20ms);
+        REQUIRE(rtt.rttvar() < 1ms);
+        REQUIRE(rtt.rto() == 200ms);
+    }
+
+    SECTION("jitter raises the RTO")
+    {
+        for (int i = 0; i < 50; ++i) {
+            rtt.add_sample(i % 2 ? 50ms : 450ms);
+        }
+        REQUIRE(rtt.srtt() > 200ms);
+        REQUIRE(rtt.srtt() < 300ms);
+        REQUIRE(rtt.rto() > 900ms);
+        REQUIRE(rtt.rto() <= 4s);
+    }
+
+    SECTION("backoff doubles up to the maximum")
+    {
+        rtt.add_sample(300ms);
+        REQUIRE(rtt.rto() == 900ms);
+        REQUIRE(rtt.backoff(0) == 900ms);
+        REQUIRE(rtt.backoff(1) == 1800ms);
+        REQUIRE(rtt.backoff(2) == 3600ms);
+        REQUIRE(rtt.backoff(3) == 4s);
+        REQUIRE(rtt.backoff(30) == 4s);
+    }
+}
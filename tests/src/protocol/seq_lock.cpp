@@ -0,0 +1,133 @@
+#include "catch2/catch.hpp"
+
+#include "client_pool/status_board.hpp"
+#include "common/seq_lock.hpp"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace {
+// Every field derived from `value`, so a torn read shows.
+struct Value
+{
+    std::uint64_t value   = 0;
+    std::uint64_t squared = 0;
+    std::uint64_t check   = 0;
+};
+
+Value make_value(std::uint64_t value)
+{
+    return Value{value, value * value, value ^ 0x5555555555555555u};
+}
+} // namespace
+
+TEST_CASE("Seq lock: load returns the last store", "[seq_lock]")
+{
+    tsvetkov::SeqLock<Value> lock;
+    REQUIRE(lock.load().value == 0);
+    REQUIRE(lock.version() == 0);
+    lock.store(make_value(7));
+    REQUIRE(lock.load().squared == 49);
+    REQUIRE(lock.version() == 1);
+}
+
+TEST_CASE("Seq lock: readers never see a torn value", "[seq_lock]")
+{
+    constexpr std::uint64_t stores = 200000;
+    tsvetkov::SeqLock<Value> lock(make_value(0));
+    std::atomic<bool> is_done{false};
+    std::atomic<std::uint64_t> torn{0};
+
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 3; ++i) {
+        readers.emplace_back([&] {
+            std::uint64_t last = 0;
+            while (!is_done.load(std::memory_order_relaxed)) {
+                auto value = lock.load();
+                if (value.squared != value.value * value.value || value.check != (value.value ^ 0x5555555555555555u) ||
+                    value.value < last) {
+                    torn.fetch_add(1);
+                }
+                last = value.value;
+            }
+        });
+    }
+    for (std::uint64_t i = 1; i <= stores; ++i) {
+        lock.store(make_value(i));
+    }
+    is_done = true;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    REQUIRE(torn == 0);
+    REQUIRE(lock.load().value == stores);
+}
+
+TEST_CASE("Status board: slots are reused and free slots are not visited", "[seq_lock]")
+{
+    using namespace tsvetkov;
+    StatusBoard board;
+    auto a = board.acquire(10);
+    auto b = board.acquire(11);
+    auto c = board.acquire(12);
+
+    auto snapshot = board.load(b);
+    REQUIRE(snapshot.device == 11);
+    REQUIRE(snapshot.is_present);
+    REQUIRE(snapshot.notifications == 0);
+
+    snapshot.pin_state.set(2, PinState::Status::On);
+    snapshot.notifications = 1;
+    board.store(b, snapshot);
+    REQUIRE(board.load(b).pin_state.status(2) == PinState::Status::On);
+
+    board.release(b);
+    std::vector<DeviceId> devices;
+    board.for_each([&](const DeviceSnapshot& each) { devices.push_back(each.device); });
+    REQUIRE(devices == std::vector<DeviceId>{10, 12});
+
+    auto d = board.acquire(13);
+    REQUIRE(d == b);
+    REQUIRE(board.load(d).device == 13);
+    REQUIRE_FALSE(board.load(d).pin_state.has(2));
+    REQUIRE(a != c);
+}
+
+TEST_CASE("Status board: grows while being read", "[seq_lock]")
+{
+    using namespace tsvetkov;
+    constexpr std::size_t devices = 3 * StatusBoard::chunk_size;
+    StatusBoard board;
+    std::atomic<bool> is_done{false};
+    std::atomic<std::uint64_t> inconsistent{0};
+
+    std::thread reader([&] {
+        while (!is_done.load(std::memory_order_relaxed)) {
+            board.for_each([&](const DeviceSnapshot& snapshot) {
+                if (snapshot.notifications != 0 && snapshot.pin_state.size() != snapshot.notifications % 8 + 1) {
+                    inconsistent.fetch_add(1);
+                }
+            });
+        }
+    });
+    for (std::size_t i = 0; i < devices; ++i) {
+        auto slot     = board.acquire(i);
+        auto snapshot = board.load(slot);
+        for (std::uint64_t n = 1; n <= 3; ++n) {
+            snapshot.notifications = n;
+            snapshot.pin_state     = PinState{};
+            for (std::uint8_t pin = 0; pin <= n % 8; ++pin) {
+                snapshot.pin_state.set(pin, PinState::Status::Off);
+            }
+            board.store(slot, snapshot);
+        }
+    }
+    is_done = true;
+    reader.join();
+
+    std::size_t count = 0;
+    board.for_each([&](const DeviceSnapshot&) { ++count; });
+    REQUIRE(inconsistent == 0);
+    REQUIRE(count == devices);
+}
@@ -0,0 +1,130 @@
+#include "catch2/catch.hpp"
+
+#include "common/timing_wheel.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+TEST_CASE("TimingWheel: fires in deadline order", "[timing_wheel]")
+{
+    asio::io_context io;
+    auto& wheel = asio::use_service<tsvetkov::TimingWheel>(io);
+
+    std::vector<int> fired;
+    tsvetkov::TimerNode late([&] { fired.push_back(3); });
+    tsvetkov::TimerNode early([&] { fired.push_back(1); });
+    tsvetkov::TimerNode middle([&] { fired.push_back(2); });
+
+    auto start = std::chrono::steady_clock::now();
+    wheel.schedule(late, 700ms);
+    wheel.schedule(early, 20ms);
+    wheel.schedule(middle, 150ms);
+    REQUIRE(wheel.size() == 3);
+
+    io.run();
+
+    REQUIRE(fired == std::vector<int>{1, 2, 3});
+    REQUIRE(wheel.size() == 0);
+    REQUIRE(std::chrono::steady_clock::now() - start >= 700ms);
+}
+
+TEST_CASE("TimingWheel: cancel and reschedule", "[timing_wheel]")
+{
+    asio::io_context io;
+    auto& wheel = asio::use_service<tsvetkov::TimingWheel>(io);
+
+    int cancelled = 0;
+    int moved     = 0;
+    tsvetkov::TimerNode a([&] { ++cancelled; });
+    tsvetkov::TimerNode b([&] { ++moved; });
+
+    wheel.schedule(a, 30ms);
+    wheel.schedule(b, 10s);
+    wheel.schedule(b, 20ms);
+    REQUIRE(wheel.size() == 2);
+
+    wheel.cancel(a);
+    REQUIRE_FALSE(wheel.is_scheduled(a));
+    {
+        tsvetkov::TimerNode destroyed([&] { ++cancelled; });
+        wheel.schedule(destroyed, 10ms);
+    }
+    REQUIRE(wheel.size() == 1);
+
+    io.run();
+
+    REQUIRE(cancelled == 0);
+    REQUIRE(moved == 1);
+}
+
+TEST_CASE("TimingWheel: a callback may re-arm its own node", "[timing_wheel]")
+{
+    asio::io_context io;
+    auto& wheel = asio::use_service<tsvetkov::TimingWheel>(io);
+
+    int ticks = 0;
+    tsvetkov::TimerNode periodic;
+    periodic.set_callback([&] {
+        if (++ticks < 5) {
+            wheel.schedule(periodic, 10ms);
+        }
+    });
+    wheel.schedule(periodic, 10ms);
+
+    io.run();
+
+    REQUIRE(ticks == 5);
+}
+
+TEST_CASE("TimingWheel: never fires before the delay", "[timing_wheel]")
+{
+    asio::io_context io;
+    auto& wheel = asio::use_service<tsvetkov::TimingWheel>(io);
+
+    std::vector<std::chrono::steady_clock::duration> early;
+    std::vector<std::unique_ptr<tsvetkov::TimerNode>> nodes;
+    for (int i = 0; i < 50; ++i) {
+        auto delay     = std::chrono::milliseconds(i % 7 * 3 + 1);
+        auto scheduled = std::chrono::steady_clock::now();
+        nodes.push_back(std::make_unique<tsvetkov::TimerNode>([&early, delay, scheduled] {
+            auto elapsed = std::chrono::steady_clock::now() - scheduled;
+            if (elapsed < delay) {
+                early.push_back(elapsed);
+            }
+        }));
+        wheel.schedule(*nodes.back(), delay);
+        std::this_thread::sleep_for(std::chrono::microseconds(1700));
+    }
+
+    io.run();
+
+    REQUIRE(early.empty());
+}
+
+TEST_CASE("TimingWheel: destroying a node waits for its running callback", "[timing_wheel]")
+{
+    asio::io_context io;
+    auto& wheel = asio::use_service<tsvetkov::TimingWheel>(io);
+
+    std::atomic<bool> is_running{false};
+    std::atomic<bool> is_finished{false};
+    auto node = std::make_unique<tsvetkov::TimerNode>([&] {
+        is_running = true;
+        std::this_thread::sleep_for(100ms);
+        is_finished = true;
+    });
+    wheel.schedule(*node, 10ms);
+
+    std::thread worker([&] { io.run(); });
+    while (!is_running) {
+        std::this_thread::yield();
+    }
+    node.reset();
+    REQUIRE(is_finished);
+    worker.join();
+}
@@ -0,0 +1,32 @@
+#include "catch2/catch.hpp"
+
+#include "common/token_bucket.hpp"
+
+using namespace std::chrono_literals;
+
+TEST_CASE("Token bucket: a burst, then the rate", "[token_bucket]")
+{
+    auto start = std::chrono::steady_clock::now();
+    tsvetkov::TokenBucket bucket(1000.0, 100.0, start);
+
+    REQUIRE(bucket.take(1000, start) == 100);
+    REQUIRE(bucket.take(1, start) == 0);
+    REQUIRE(bucket.time_until(10, start) == 10ms);
+    REQUIRE(bucket.take(1000, start + 10ms) == 10);
+    // never more than the burst saved
+    REQUIRE(bucket.take(1000, start + 1s) == 100);
+    REQUIRE(bucket.time_until(1000, start + 1s) == 100ms);
+
+    bucket.refund(30);
+    REQUIRE(bucket.take(1000, start + 1s) == 30);
+}
+
+TEST_CASE("Token bucket: no rate means no limit", "[token_bucket]")
+{
+    auto start = std::chrono::steady_clock::now();
+    tsvetkov::TokenBucket bucket(0.0, 16.0, start);
+
+    REQUIRE(bucket.take(1000, start) == 16);
+    REQUIRE(bucket.take(1000, start) == 16);
+    REQUIRE(bucket.time_until(16, start) == std::chrono::steady_clock::duration::zero());
+}